@@ -92,6 +92,10 @@ Build Options
 #define DR_WAV_NO_STDIO
   Disables APIs that initialize a decoder from a file such as `drwav_init_file()`, `drwav_init_file_write()`, etc.
 
+#define DR_WAV_NO_SIMD
+  Disables the SSE2, AVX2 and AVX-512 sample conversion kernels. Without this they are compiled in on x86 and x64 and the best one
+  the CPU supports is picked the first time a conversion runs, falling back to the scalar code.
+
 
 
 Notes
@@ -1347,6 +1351,41 @@ DRWAV_API drwav_bool32 drwav_fourcc_equal(const drwav_uint8* a, const char* b);
     #define DRWAV_ARM
 #endif
 
+/* SIMD. The kernels are compiled for every instruction set the compiler can target and picked at run time. */
+#if !defined(DR_WAV_NO_SIMD) && !defined(DR_WAV_NO_CONVERSION_API) && (defined(DRWAV_X64) || defined(DRWAV_X86))
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #if _MSC_VER >= 1400 && (defined(DRWAV_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+            #define DRWAV_SUPPORT_SSE2
+        #endif
+        #if _MSC_VER >= 1700
+            #define DRWAV_SUPPORT_AVX2
+        #endif
+        #if _MSC_VER >= 1911
+            #define DRWAV_SUPPORT_AVX512
+        #endif
+        #define DRWAV_TARGET_SSE2
+        #define DRWAV_TARGET_AVX2
+        #define DRWAV_TARGET_AVX512
+    #elif defined(__clang__) || (defined(__GNUC__) && ((__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+        #define DRWAV_SUPPORT_SSE2
+        #define DRWAV_SUPPORT_AVX2
+        #define DRWAV_SUPPORT_AVX512
+        #define DRWAV_TARGET_SSE2   __attribute__((target("sse2")))
+        #define DRWAV_TARGET_AVX2   __attribute__((target("avx2")))
+        #define DRWAV_TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+    #endif
+#endif
+
+#if defined(DRWAV_SUPPORT_SSE2) || defined(DRWAV_SUPPORT_AVX2) || defined(DRWAV_SUPPORT_AVX512)
+    #define DRWAV_SUPPORT_SIMD
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+    #endif
+    #include <immintrin.h>
+#endif
+
 #ifdef _MSC_VER
     #define DRWAV_INLINE __forceinline
 #elif defined(__GNUC__)
@@ -5273,6 +5312,51 @@ DRWAV_PRIVATE drwav_bool32 drwav_seek_to_first_pcm_frame(drwav* pWav)
     return DRWAV_TRUE;
 }
 
+DRWAV_PRIVATE drwav_uint64 drwav__get_pcm_frames_per_compressed_block(drwav* pWav)
+{
+    /* The header of each block holds the first frames (two for MS-ADPCM, one for IMA), the rest is two frames per byte per channel. */
+    if (pWav->translatedFormatTag == DR_WAVE_FORMAT_ADPCM) {
+        if (pWav->fmt.blockAlign <= 7*pWav->channels) {
+            return 0;
+        }
+        return 2 + ((pWav->fmt.blockAlign - 7*pWav->channels) * 2) / pWav->channels;
+    }
+
+    if (pWav->translatedFormatTag == DR_WAVE_FORMAT_DVI_ADPCM) {
+        if (pWav->fmt.blockAlign <= 4*pWav->channels) {
+            return 0;
+        }
+        return 1 + ((pWav->fmt.blockAlign - 4*pWav->channels) * 2) / pWav->channels;
+    }
+
+    return 0;
+}
+
+DRWAV_PRIVATE drwav_bool32 drwav_seek_to_compressed_block(drwav* pWav, drwav_uint64 blockIndex, drwav_uint64 framesPerBlock)
+{
+    drwav_uint64 offset;
+
+    /* This resets the decoder state which is all that's needed to start decoding from the top of a block. */
+    if (!drwav_seek_to_first_pcm_frame(pWav)) {
+        return DRWAV_FALSE;
+    }
+
+    offset = blockIndex * pWav->fmt.blockAlign;
+    while (offset > 0) {
+        int offset32 = ((offset > INT_MAX) ? INT_MAX : (int)offset);
+        if (!pWav->onSeek(pWav->pUserData, offset32, drwav_seek_origin_current)) {
+            return DRWAV_FALSE;
+        }
+
+        pWav->bytesRemaining -= offset32;
+        offset               -= offset32;
+    }
+
+    pWav->readCursorInPCMFrames = blockIndex * framesPerBlock;
+
+    return DRWAV_TRUE;
+}
+
 DRWAV_API drwav_bool32 drwav_seek_to_pcm_frame(drwav* pWav, drwav_uint64 targetFrameIndex)
 {
     /* Seeking should be compatible with wave files > 2GB. */
@@ -5297,17 +5381,21 @@ DRWAV_API drwav_bool32 drwav_seek_to_pcm_frame(drwav* pWav, drwav_uint64 targetF
     }
 
     /*
-    For compressed formats we just use a slow generic seek. If we are seeking forward we just seek forward. If we are going backwards we need
-    to seek back to the start.
+    For compressed formats every block is blockAlign bytes and decodes independently of the others, so we can jump straight to the block
+    containing the target frame and decode forward from there, which is never more than one block. If the target is further into the block
+    we're already in we just keep decoding. Blocks too small to hold their own header fall back to decoding from the start.
     */
     if (drwav__is_compressed_format_tag(pWav->translatedFormatTag)) {
-        /* TODO: This can be optimized. */
+        drwav_uint64 framesPerBlock = drwav__get_pcm_frames_per_compressed_block(pWav);
 
-        /*
-        If we're seeking forward it's simple - just keep reading samples until we hit the sample we're requesting. If we're seeking backwards,
-        we first need to seek back to the start and then just do the same thing as a forward seek.
-        */
-        if (targetFrameIndex < pWav->readCursorInPCMFrames) {
+        if (framesPerBlock > 0) {
+            drwav_uint64 targetBlockIndex = targetFrameIndex / framesPerBlock;
+            if (targetFrameIndex < pWav->readCursorInPCMFrames || targetBlockIndex != pWav->readCursorInPCMFrames / framesPerBlock) {
+                if (!drwav_seek_to_compressed_block(pWav, targetBlockIndex, framesPerBlock)) {
+                    return DRWAV_FALSE;
+                }
+            }
+        } else if (targetFrameIndex < pWav->readCursorInPCMFrames) {
             if (!drwav_seek_to_first_pcm_frame(pWav)) {
                 return DRWAV_FALSE;
             }
@@ -5921,6 +6009,689 @@ static DRWAV_INLINE drwav_int16 drwav__mulaw_to_s16(drwav_uint8 sampleIn)
 }
 
 
+#if defined(DRWAV_SUPPORT_SIMD)
+/*
+SIMD conversion kernels. Each one converts as many whole vectors as it can and returns how many samples it has done, leaving the tail
+to the scalar loop of the public function. The results are bit-exact with the scalar code: every conversion is either integer only or
+a single rounding of a value that is exact in the scalar path as well.
+*/
+#define DRWAV_CPU_SSE2      0x01
+#define DRWAV_CPU_AVX2      0x02
+#define DRWAV_CPU_AVX512    0x04
+
+typedef size_t (* drwav_simd_proc)(void* pOut, const void* pIn, size_t sampleCount);
+
+typedef struct
+{
+    drwav_simd_proc u8_to_s16;
+    drwav_simd_proc s24_to_s16;
+    drwav_simd_proc s32_to_s16;
+    drwav_simd_proc f32_to_s16;
+    drwav_simd_proc u8_to_f32;
+    drwav_simd_proc s16_to_f32;
+    drwav_simd_proc s24_to_f32;
+    drwav_simd_proc s32_to_f32;
+    drwav_simd_proc u8_to_s32;
+    drwav_simd_proc s16_to_s32;
+    drwav_simd_proc s24_to_s32;
+    drwav_simd_proc f32_to_s32;
+} drwav_simd_kernels;
+
+static void drwav__cpuid(unsigned int info[4], unsigned int function, unsigned int subfunction)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int regs[4];
+    __cpuidex(regs, (int)function, (int)subfunction);
+    info[0] = (unsigned int)regs[0];
+    info[1] = (unsigned int)regs[1];
+    info[2] = (unsigned int)regs[2];
+    info[3] = (unsigned int)regs[3];
+#else
+    if (__get_cpuid_max(0, NULL) < function) {
+        info[0] = info[1] = info[2] = info[3] = 0;
+        return;
+    }
+    __cpuid_count(function, subfunction, info[0], info[1], info[2], info[3]);
+#endif
+}
+
+static drwav_uint64 drwav__xgetbv(void)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    return (drwav_uint64)_xgetbv(0);
+#else
+    unsigned int lo, hi;
+    __asm__ __volatile__ ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((drwav_uint64)hi << 32) | lo;
+#endif
+}
+
+/* The OS has to save the wider registers too, not just the CPU support the instructions. */
+static drwav_uint32 drwav__get_cpu_caps(void)
+{
+    unsigned int info1[4], info7[4];
+    drwav_uint64 xcr0 = 0;
+    drwav_uint32 caps = 0;
+
+    drwav__cpuid(info1, 0, 0);
+    if (info1[0] < 1) {
+        return 0;
+    }
+
+    drwav__cpuid(info1, 1, 0);
+    drwav__cpuid(info7, 7, 0);
+    if ((info1[3] & (1u << 26)) != 0) {
+        caps |= DRWAV_CPU_SSE2;
+    }
+
+    if ((info1[2] & (1u << 27)) == 0 || (info1[2] & (1u << 28)) == 0) {
+        return caps;
+    }
+
+    xcr0 = drwav__xgetbv();
+    if ((xcr0 & 0x06) == 0x06 && (info7[1] & (1u << 5)) != 0) {
+        caps |= DRWAV_CPU_AVX2;
+    }
+    if ((xcr0 & 0xE6) == 0xE6 && (info7[1] & (1u << 16)) != 0 && (info7[1] & (1u << 30)) != 0) {
+        caps |= DRWAV_CPU_AVX512;
+    }
+
+    return caps;
+}
+
+static size_t drwav__simd_none(void* pOut, const void* pIn, size_t sampleCount)
+{
+    (void)pOut;
+    (void)pIn;
+    (void)sampleCount;
+    return 0;
+}
+
+
+#if defined(DRWAV_SUPPORT_SSE2)
+DRWAV_TARGET_SSE2 static DRWAV_INLINE __m128i drwav__s24_load4_sse2(const drwav_uint8* p)
+{
+    /* No byte shuffles before SSSE3, the samples are put together in general purpose registers. */
+    return _mm_setr_epi32(
+        (int)(((drwav_uint32)p[0] << 8) | ((drwav_uint32)p[ 1] << 16) | ((drwav_uint32)p[ 2] << 24)),
+        (int)(((drwav_uint32)p[3] << 8) | ((drwav_uint32)p[ 4] << 16) | ((drwav_uint32)p[ 5] << 24)),
+        (int)(((drwav_uint32)p[6] << 8) | ((drwav_uint32)p[ 7] << 16) | ((drwav_uint32)p[ 8] << 24)),
+        (int)(((drwav_uint32)p[9] << 8) | ((drwav_uint32)p[10] << 16) | ((drwav_uint32)p[11] << 24)));
+}
+
+DRWAV_TARGET_SSE2 static size_t drwav__u8_to_s16_sse2(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i sign = _mm_set1_epi16((short)0x8000);
+    for (i = 0; i + 16 <= sampleCount; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)((const drwav_uint8*)pIn + i));
+        _mm_storeu_si128((__m128i*)((drwav_int16*)pOut + i + 0), _mm_xor_si128(_mm_unpacklo_epi8(zero, x), sign));
+        _mm_storeu_si128((__m128i*)((drwav_int16*)pOut + i + 8), _mm_xor_si128(_mm_unpackhi_epi8(zero, x), sign));
+    }
+    return i;
+}
+
+DRWAV_TARGET_SSE2 static size_t drwav__s24_to_s16_sse2(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    for (i = 0; i + 8 <= sampleCount; i += 8) {
+        __m128i a = _mm_srai_epi32(drwav__s24_load4_sse2((const drwav_uint8*)pIn + i*3 +  0), 16);
+        __m128i b = _mm_srai_epi32(drwav__s24_load4_sse2((const drwav_uint8*)pIn + i*3 + 12), 16);
+        _mm_storeu_si128((__m128i*)((drwav_int16*)pOut + i), _mm_packs_epi32(a, b));
+    }
+    return i;
+}
+
+DRWAV_TARGET_SSE2 static size_t drwav__s32_to_s16_sse2(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    for (i = 0; i + 8 <= sampleCount; i += 8) {
+        __m128i a = _mm_srai_epi32(_mm_loadu_si128((const __m128i*)((const drwav_int32*)pIn + i + 0)), 16);
+        __m128i b = _mm_srai_epi32(_mm_loadu_si128((const __m128i*)((const drwav_int32*)pIn + i + 4)), 16);
+        _mm_storeu_si128((__m128i*)((drwav_int16*)pOut + i), _mm_packs_epi32(a, b));
+    }
+    return i;
+}
+
+DRWAV_TARGET_SSE2 static size_t drwav__f32_to_s16_sse2(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    const __m128 lo = _mm_set1_ps(-1.0f);
+    const __m128 hi = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(32767.5f);
+    const __m128i bias = _mm_set1_epi32(32768);
+    for (i = 0; i + 8 <= sampleCount; i += 8) {
+        __m128 x0 = _mm_loadu_ps((const float*)pIn + i + 0);
+        __m128 x1 = _mm_loadu_ps((const float*)pIn + i + 4);
+        __m128i r0 = _mm_cvttps_epi32(_mm_mul_ps(_mm_add_ps(_mm_min_ps(_mm_max_ps(x0, lo), hi), hi), scale));
+        __m128i r1 = _mm_cvttps_epi32(_mm_mul_ps(_mm_add_ps(_mm_min_ps(_mm_max_ps(x1, lo), hi), hi), scale));
+        _mm_storeu_si128((__m128i*)((drwav_int16*)pOut + i), _mm_packs_epi32(_mm_sub_epi32(r0, bias), _mm_sub_epi32(r1, bias)));
+    }
+    return i;
+}
+
+DRWAV_TARGET_SSE2 static size_t drwav__u8_to_f32_sse2(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 scale = _mm_set1_ps(0.00784313725490196078f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (i = 0; i + 16 <= sampleCount; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)((const drwav_uint8*)pIn + i));
+        __m128i a = _mm_unpacklo_epi8(x, zero);
+        __m128i b = _mm_unpackhi_epi8(x, zero);
+        _mm_storeu_ps((float*)pOut + i +  0, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(a, zero)), scale), one));
+        _mm_storeu_ps((float*)pOut + i +  4, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(a, zero)), scale), one));
+        _mm_storeu_ps((float*)pOut + i +  8, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(b, zero)), scale), one));
+        _mm_storeu_ps((float*)pOut + i + 12, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(b, zero)), scale), one));
+    }
+    return i;
+}
+
+DRWAV_TARGET_SSE2 static size_t drwav__s16_to_f32_sse2(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    const __m128 scale = _mm_set1_ps(0.000030517578125f);
+    for (i = 0; i + 8 <= sampleCount; i += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i*)((const drwav_int16*)pIn + i));
+        _mm_storeu_ps((float*)pOut + i + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16)), scale));
+        _mm_storeu_ps((float*)pOut + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16)), scale));
+    }
+    return i;
+}
+
+DRWAV_TARGET_SSE2 static size_t drwav__s24_to_f32_sse2(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    const __m128 scale = _mm_set1_ps(0.00000011920928955078125f);
+    for (i = 0; i + 4 <= sampleCount; i += 4) {
+        __m128i x = _mm_srai_epi32(drwav__s24_load4_sse2((const drwav_uint8*)pIn + i*3), 8);
+        _mm_storeu_ps((float*)pOut + i, _mm_mul_ps(_mm_cvtepi32_ps(x), scale));
+    }
+    return i;
+}
+
+DRWAV_TARGET_SSE2 static size_t drwav__s32_to_f32_sse2(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    const __m128 scale = _mm_set1_ps(1.0f / 2147483648.0f);
+    for (i = 0; i + 4 <= sampleCount; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)((const drwav_int32*)pIn + i));
+        _mm_storeu_ps((float*)pOut + i, _mm_mul_ps(_mm_cvtepi32_ps(x), scale));
+    }
+    return i;
+}
+
+DRWAV_TARGET_SSE2 static size_t drwav__u8_to_s32_sse2(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i sign = _mm_set1_epi32((int)0x80000000);
+    for (i = 0; i + 16 <= sampleCount; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)((const drwav_uint8*)pIn + i));
+        __m128i a = _mm_unpacklo_epi8(zero, x);
+        __m128i b = _mm_unpackhi_epi8(zero, x);
+        _mm_storeu_si128((__m128i*)((drwav_int32*)pOut + i +  0), _mm_xor_si128(_mm_unpacklo_epi16(zero, a), sign));
+        _mm_storeu_si128((__m128i*)((drwav_int32*)pOut + i +  4), _mm_xor_si128(_mm_unpackhi_epi16(zero, a), sign));
+        _mm_storeu_si128((__m128i*)((drwav_int32*)pOut + i +  8), _mm_xor_si128(_mm_unpacklo_epi16(zero, b), sign));
+        _mm_storeu_si128((__m128i*)((drwav_int32*)pOut + i + 12), _mm_xor_si128(_mm_unpackhi_epi16(zero, b), sign));
+    }
+    return i;
+}
+
+DRWAV_TARGET_SSE2 static size_t drwav__s16_to_s32_sse2(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    const __m128i zero = _mm_setzero_si128();
+    for (i = 0; i + 8 <= sampleCount; i += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i*)((const drwav_int16*)pIn + i));
+        _mm_storeu_si128((__m128i*)((drwav_int32*)pOut + i + 0), _mm_unpacklo_epi16(zero, x));
+        _mm_storeu_si128((__m128i*)((drwav_int32*)pOut + i + 4), _mm_unpackhi_epi16(zero, x));
+    }
+    return i;
+}
+
+DRWAV_TARGET_SSE2 static size_t drwav__s24_to_s32_sse2(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    for (i = 0; i + 4 <= sampleCount; i += 4) {
+        _mm_storeu_si128((__m128i*)((drwav_int32*)pOut + i), drwav__s24_load4_sse2((const drwav_uint8*)pIn + i*3));
+    }
+    return i;
+}
+
+DRWAV_TARGET_SSE2 static size_t drwav__f32_to_s32_sse2(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    const __m128 scale = _mm_set1_ps(2147483648.0f);
+    for (i = 0; i + 4 <= sampleCount; i += 4) {
+        __m128 x = _mm_loadu_ps((const float*)pIn + i);
+        _mm_storeu_si128((__m128i*)((drwav_int32*)pOut + i), _mm_cvttps_epi32(_mm_mul_ps(x, scale)));
+    }
+    return i;
+}
+#endif  /* DRWAV_SUPPORT_SSE2 */
+
+
+#if defined(DRWAV_SUPPORT_AVX2)
+/* Eight packed 24-bit samples, each moved to the top three bytes of a 32-bit lane. Only the 24 bytes that belong to them are read. */
+DRWAV_TARGET_AVX2 static DRWAV_INLINE __m256i drwav__s24_load8_avx2(const drwav_uint8* p)
+{
+    const __m256i mask = _mm256_setr_epi32(-1, -1, -1, -1, -1, -1, 0, 0);
+    const __m256i spread = _mm256_setr_epi32(0, 1, 2, 2, 3, 4, 5, 5);
+    const __m256i bytes = _mm256_setr_epi8(
+        -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+        -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    __m256i x = _mm256_maskload_epi32((const int*)p, mask);
+    return _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(x, spread), bytes);
+}
+
+DRWAV_TARGET_AVX2 static DRWAV_INLINE __m128i drwav__narrow8_avx2(__m256i x)
+{
+    return _mm_packs_epi32(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+}
+
+DRWAV_TARGET_AVX2 static size_t drwav__u8_to_s16_avx2(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    const __m256i sign = _mm256_set1_epi16((short)0x8000);
+    for (i = 0; i + 16 <= sampleCount; i += 16) {
+        __m256i x = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)((const drwav_uint8*)pIn + i)));
+        _mm256_storeu_si256((__m256i*)((drwav_int16*)pOut + i), _mm256_xor_si256(_mm256_slli_epi16(x, 8), sign));
+    }
+    return i;
+}
+
+DRWAV_TARGET_AVX2 static size_t drwav__s24_to_s16_avx2(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    for (i = 0; i + 8 <= sampleCount; i += 8) {
+        __m256i x = _mm256_srai_epi32(drwav__s24_load8_avx2((const drwav_uint8*)pIn + i*3), 16);
+        _mm_storeu_si128((__m128i*)((drwav_int16*)pOut + i), drwav__narrow8_avx2(x));
+    }
+    return i;
+}
+
+DRWAV_TARGET_AVX2 static size_t drwav__s32_to_s16_avx2(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    for (i = 0; i + 8 <= sampleCount; i += 8) {
+        __m256i x = _mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)((const drwav_int32*)pIn + i)), 16);
+        _mm_storeu_si128((__m128i*)((drwav_int16*)pOut + i), drwav__narrow8_avx2(x));
+    }
+    return i;
+}
+
+DRWAV_TARGET_AVX2 static size_t drwav__f32_to_s16_avx2(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    const __m256 lo = _mm256_set1_ps(-1.0f);
+    const __m256 hi = _mm256_set1_ps(1.0f);
+    const __m256 scale = _mm256_set1_ps(32767.5f);
+    const __m256i bias = _mm256_set1_epi32(32768);
+    for (i = 0; i + 8 <= sampleCount; i += 8) {
+        __m256 x = _mm256_loadu_ps((const float*)pIn + i);
+        __m256i r = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_add_ps(_mm256_min_ps(_mm256_max_ps(x, lo), hi), hi), scale));
+        _mm_storeu_si128((__m128i*)((drwav_int16*)pOut + i), drwav__narrow8_avx2(_mm256_sub_epi32(r, bias)));
+    }
+    return i;
+}
+
+DRWAV_TARGET_AVX2 static size_t drwav__u8_to_f32_avx2(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    const __m256 scale = _mm256_set1_ps(0.00784313725490196078f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    for (i = 0; i + 8 <= sampleCount; i += 8) {
+        __m256i x = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)((const drwav_uint8*)pIn + i)));
+        _mm256_storeu_ps((float*)pOut + i, _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(x), scale), one));
+    }
+    return i;
+}
+
+DRWAV_TARGET_AVX2 static size_t drwav__s16_to_f32_avx2(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    const __m256 scale = _mm256_set1_ps(0.000030517578125f);
+    for (i = 0; i + 8 <= sampleCount; i += 8) {
+        __m256i x = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)((const drwav_int16*)pIn + i)));
+        _mm256_storeu_ps((float*)pOut + i, _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale));
+    }
+    return i;
+}
+
+DRWAV_TARGET_AVX2 static size_t drwav__s24_to_f32_avx2(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    const __m256 scale = _mm256_set1_ps(0.00000011920928955078125f);
+    for (i = 0; i + 8 <= sampleCount; i += 8) {
+        __m256i x = _mm256_srai_epi32(drwav__s24_load8_avx2((const drwav_uint8*)pIn + i*3), 8);
+        _mm256_storeu_ps((float*)pOut + i, _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale));
+    }
+    return i;
+}
+
+DRWAV_TARGET_AVX2 static size_t drwav__s32_to_f32_avx2(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    const __m256 scale = _mm256_set1_ps(1.0f / 2147483648.0f);
+    for (i = 0; i + 8 <= sampleCount; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)((const drwav_int32*)pIn + i));
+        _mm256_storeu_ps((float*)pOut + i, _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale));
+    }
+    return i;
+}
+
+DRWAV_TARGET_AVX2 static size_t drwav__u8_to_s32_avx2(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    const __m256i sign = _mm256_set1_epi32((int)0x80000000);
+    for (i = 0; i + 8 <= sampleCount; i += 8) {
+        __m256i x = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)((const drwav_uint8*)pIn + i)));
+        _mm256_storeu_si256((__m256i*)((drwav_int32*)pOut + i), _mm256_xor_si256(_mm256_slli_epi32(x, 24), sign));
+    }
+    return i;
+}
+
+DRWAV_TARGET_AVX2 static size_t drwav__s16_to_s32_avx2(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    for (i = 0; i + 8 <= sampleCount; i += 8) {
+        __m256i x = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)((const drwav_int16*)pIn + i)));
+        _mm256_storeu_si256((__m256i*)((drwav_int32*)pOut + i), _mm256_slli_epi32(x, 16));
+    }
+    return i;
+}
+
+DRWAV_TARGET_AVX2 static size_t drwav__s24_to_s32_avx2(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    for (i = 0; i + 8 <= sampleCount; i += 8) {
+        _mm256_storeu_si256((__m256i*)((drwav_int32*)pOut + i), drwav__s24_load8_avx2((const drwav_uint8*)pIn + i*3));
+    }
+    return i;
+}
+
+DRWAV_TARGET_AVX2 static size_t drwav__f32_to_s32_avx2(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    const __m256 scale = _mm256_set1_ps(2147483648.0f);
+    for (i = 0; i + 8 <= sampleCount; i += 8) {
+        __m256 x = _mm256_loadu_ps((const float*)pIn + i);
+        _mm256_storeu_si256((__m256i*)((drwav_int32*)pOut + i), _mm256_cvttps_epi32(_mm256_mul_ps(x, scale)));
+    }
+    return i;
+}
+#endif  /* DRWAV_SUPPORT_AVX2 */
+
+
+#if defined(DRWAV_SUPPORT_AVX512)
+/*
+Same as the AVX2 loader with sixteen samples. The masked load keeps it from reading past the 48 bytes of input. There is no AVX-512
+u8 to f32 kernel because with FMA available the compiler is free to fuse its multiply and subtract, which would change the rounding.
+*/
+DRWAV_TARGET_AVX512 static DRWAV_INLINE __m512i drwav__s24_load16_avx512(const drwav_uint8* p)
+{
+    const __m512i spread = _mm512_setr_epi32(0, 1, 2, 2, 3, 4, 5, 5, 6, 7, 8, 8, 9, 10, 11, 11);
+    const __m512i bytes = _mm512_set4_epi32(0x0B0A09FF, 0x080706FF, 0x050403FF, 0x020100FF);
+    __m512i x = _mm512_maskz_loadu_epi32(0x0FFF, p);
+    return _mm512_shuffle_epi8(_mm512_permutexvar_epi32(spread, x), bytes);
+}
+
+DRWAV_TARGET_AVX512 static size_t drwav__u8_to_s16_avx512(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    const __m512i sign = _mm512_set1_epi16((short)0x8000);
+    for (i = 0; i + 32 <= sampleCount; i += 32) {
+        __m512i x = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i*)((const drwav_uint8*)pIn + i)));
+        _mm512_storeu_si512((drwav_int16*)pOut + i, _mm512_xor_si512(_mm512_slli_epi16(x, 8), sign));
+    }
+    return i;
+}
+
+DRWAV_TARGET_AVX512 static size_t drwav__s24_to_s16_avx512(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    for (i = 0; i + 16 <= sampleCount; i += 16) {
+        __m512i x = _mm512_srai_epi32(drwav__s24_load16_avx512((const drwav_uint8*)pIn + i*3), 16);
+        _mm256_storeu_si256((__m256i*)((drwav_int16*)pOut + i), _mm512_cvtepi32_epi16(x));
+    }
+    return i;
+}
+
+DRWAV_TARGET_AVX512 static size_t drwav__s32_to_s16_avx512(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    for (i = 0; i + 16 <= sampleCount; i += 16) {
+        __m512i x = _mm512_srai_epi32(_mm512_loadu_si512((const drwav_int32*)pIn + i), 16);
+        _mm256_storeu_si256((__m256i*)((drwav_int16*)pOut + i), _mm512_cvtepi32_epi16(x));
+    }
+    return i;
+}
+
+DRWAV_TARGET_AVX512 static size_t drwav__f32_to_s16_avx512(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    const __m512 lo = _mm512_set1_ps(-1.0f);
+    const __m512 hi = _mm512_set1_ps(1.0f);
+    const __m512 scale = _mm512_set1_ps(32767.5f);
+    const __m512i bias = _mm512_set1_epi32(32768);
+    for (i = 0; i + 16 <= sampleCount; i += 16) {
+        __m512 x = _mm512_loadu_ps((const float*)pIn + i);
+        __m512i r = _mm512_cvttps_epi32(_mm512_mul_ps(_mm512_add_ps(_mm512_min_ps(_mm512_max_ps(x, lo), hi), hi), scale));
+        _mm256_storeu_si256((__m256i*)((drwav_int16*)pOut + i), _mm512_cvtepi32_epi16(_mm512_sub_epi32(r, bias)));
+    }
+    return i;
+}
+
+DRWAV_TARGET_AVX512 static size_t drwav__s16_to_f32_avx512(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    const __m512 scale = _mm512_set1_ps(0.000030517578125f);
+    for (i = 0; i + 16 <= sampleCount; i += 16) {
+        __m512i x = _mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i*)((const drwav_int16*)pIn + i)));
+        _mm512_storeu_ps((float*)pOut + i, _mm512_mul_ps(_mm512_cvtepi32_ps(x), scale));
+    }
+    return i;
+}
+
+DRWAV_TARGET_AVX512 static size_t drwav__s24_to_f32_avx512(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    const __m512 scale = _mm512_set1_ps(0.00000011920928955078125f);
+    for (i = 0; i + 16 <= sampleCount; i += 16) {
+        __m512i x = _mm512_srai_epi32(drwav__s24_load16_avx512((const drwav_uint8*)pIn + i*3), 8);
+        _mm512_storeu_ps((float*)pOut + i, _mm512_mul_ps(_mm512_cvtepi32_ps(x), scale));
+    }
+    return i;
+}
+
+DRWAV_TARGET_AVX512 static size_t drwav__s32_to_f32_avx512(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    const __m512 scale = _mm512_set1_ps(1.0f / 2147483648.0f);
+    for (i = 0; i + 16 <= sampleCount; i += 16) {
+        __m512i x = _mm512_loadu_si512((const drwav_int32*)pIn + i);
+        _mm512_storeu_ps((float*)pOut + i, _mm512_mul_ps(_mm512_cvtepi32_ps(x), scale));
+    }
+    return i;
+}
+
+DRWAV_TARGET_AVX512 static size_t drwav__u8_to_s32_avx512(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    const __m512i sign = _mm512_set1_epi32((int)0x80000000);
+    for (i = 0; i + 16 <= sampleCount; i += 16) {
+        __m512i x = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*)((const drwav_uint8*)pIn + i)));
+        _mm512_storeu_si512((drwav_int32*)pOut + i, _mm512_xor_si512(_mm512_slli_epi32(x, 24), sign));
+    }
+    return i;
+}
+
+DRWAV_TARGET_AVX512 static size_t drwav__s16_to_s32_avx512(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    for (i = 0; i + 16 <= sampleCount; i += 16) {
+        __m512i x = _mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i*)((const drwav_int16*)pIn + i)));
+        _mm512_storeu_si512((drwav_int32*)pOut + i, _mm512_slli_epi32(x, 16));
+    }
+    return i;
+}
+
+DRWAV_TARGET_AVX512 static size_t drwav__s24_to_s32_avx512(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    for (i = 0; i + 16 <= sampleCount; i += 16) {
+        _mm512_storeu_si512((drwav_int32*)pOut + i, drwav__s24_load16_avx512((const drwav_uint8*)pIn + i*3));
+    }
+    return i;
+}
+
+DRWAV_TARGET_AVX512 static size_t drwav__f32_to_s32_avx512(void* pOut, const void* pIn, size_t sampleCount)
+{
+    size_t i;
+    const __m512 scale = _mm512_set1_ps(2147483648.0f);
+    for (i = 0; i + 16 <= sampleCount; i += 16) {
+        __m512 x = _mm512_loadu_ps((const float*)pIn + i);
+        _mm512_storeu_si512((drwav_int32*)pOut + i, _mm512_cvttps_epi32(_mm512_mul_ps(x, scale)));
+    }
+    return i;
+}
+#endif  /* DRWAV_SUPPORT_AVX512 */
+
+
+static drwav_simd_kernels g_drwavSimdKernels;
+static const drwav_simd_kernels g_drwavSimdKernelsScalar = {
+    drwav__simd_none, drwav__simd_none, drwav__simd_none, drwav__simd_none,
+    drwav__simd_none, drwav__simd_none, drwav__simd_none, drwav__simd_none,
+    drwav__simd_none, drwav__simd_none, drwav__simd_none, drwav__simd_none
+};
+
+/* 0 until a thread claims the table, 1 while it fills it in and 2 once it can be read. */
+static volatile long g_drwavSimdKernelsState = 0;
+
+static long drwav__simd_state_load(void)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    return _InterlockedCompareExchange(&g_drwavSimdKernelsState, 0, 0);
+#else
+    return __atomic_load_n(&g_drwavSimdKernelsState, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static drwav_bool32 drwav__simd_state_claim(void)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    return _InterlockedCompareExchange(&g_drwavSimdKernelsState, 1, 0) == 0;
+#else
+    long expected = 0;
+    return __atomic_compare_exchange_n(&g_drwavSimdKernelsState, &expected, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+#endif
+}
+
+static void drwav__simd_state_publish(void)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    _InterlockedExchange(&g_drwavSimdKernelsState, 2);
+#else
+    __atomic_store_n(&g_drwavSimdKernelsState, 2, __ATOMIC_RELEASE);
+#endif
+}
+
+/*
+Picks the widest kernel the CPU can run for every conversion. The first caller claims the table and fills it in; anyone who gets
+here while that is still going on is handed the scalar table for that one call instead of waiting. The kernels give the same results
+as the scalar code, so that only costs a little speed.
+*/
+static const drwav_simd_kernels* drwav__get_simd_kernels(void)
+{
+    drwav_simd_kernels k;
+    drwav_uint32 caps;
+
+    if (drwav__simd_state_load() == 2) {
+        return &g_drwavSimdKernels;
+    }
+
+    if (!drwav__simd_state_claim()) {
+        return &g_drwavSimdKernelsScalar;
+    }
+
+    caps = drwav__get_cpu_caps();
+    (void)caps;
+
+    k.u8_to_s16  = drwav__simd_none;
+    k.s24_to_s16 = drwav__simd_none;
+    k.s32_to_s16 = drwav__simd_none;
+    k.f32_to_s16 = drwav__simd_none;
+    k.u8_to_f32  = drwav__simd_none;
+    k.s16_to_f32 = drwav__simd_none;
+    k.s24_to_f32 = drwav__simd_none;
+    k.s32_to_f32 = drwav__simd_none;
+    k.u8_to_s32  = drwav__simd_none;
+    k.s16_to_s32 = drwav__simd_none;
+    k.s24_to_s32 = drwav__simd_none;
+    k.f32_to_s32 = drwav__simd_none;
+
+#if defined(DRWAV_SUPPORT_SSE2)
+    if (caps & DRWAV_CPU_SSE2) {
+        k.u8_to_s16  = drwav__u8_to_s16_sse2;
+        k.s24_to_s16 = drwav__s24_to_s16_sse2;
+        k.s32_to_s16 = drwav__s32_to_s16_sse2;
+        k.f32_to_s16 = drwav__f32_to_s16_sse2;
+        k.u8_to_f32  = drwav__u8_to_f32_sse2;
+        k.s16_to_f32 = drwav__s16_to_f32_sse2;
+        k.s24_to_f32 = drwav__s24_to_f32_sse2;
+        k.s32_to_f32 = drwav__s32_to_f32_sse2;
+        k.u8_to_s32  = drwav__u8_to_s32_sse2;
+        k.s16_to_s32 = drwav__s16_to_s32_sse2;
+        k.s24_to_s32 = drwav__s24_to_s32_sse2;
+        k.f32_to_s32 = drwav__f32_to_s32_sse2;
+    }
+#endif
+#if defined(DRWAV_SUPPORT_AVX2)
+    if (caps & DRWAV_CPU_AVX2) {
+        k.u8_to_s16  = drwav__u8_to_s16_avx2;
+        k.s24_to_s16 = drwav__s24_to_s16_avx2;
+        k.s32_to_s16 = drwav__s32_to_s16_avx2;
+        k.f32_to_s16 = drwav__f32_to_s16_avx2;
+        k.u8_to_f32  = drwav__u8_to_f32_avx2;
+        k.s16_to_f32 = drwav__s16_to_f32_avx2;
+        k.s24_to_f32 = drwav__s24_to_f32_avx2;
+        k.s32_to_f32 = drwav__s32_to_f32_avx2;
+        k.u8_to_s32  = drwav__u8_to_s32_avx2;
+        k.s16_to_s32 = drwav__s16_to_s32_avx2;
+        k.s24_to_s32 = drwav__s24_to_s32_avx2;
+        k.f32_to_s32 = drwav__f32_to_s32_avx2;
+    }
+#endif
+#if defined(DRWAV_SUPPORT_AVX512)
+    if (caps & DRWAV_CPU_AVX512) {
+        k.u8_to_s16  = drwav__u8_to_s16_avx512;
+        k.s24_to_s16 = drwav__s24_to_s16_avx512;
+        k.s32_to_s16 = drwav__s32_to_s16_avx512;
+        k.f32_to_s16 = drwav__f32_to_s16_avx512;
+        k.s16_to_f32 = drwav__s16_to_f32_avx512;
+        k.s24_to_f32 = drwav__s24_to_f32_avx512;
+        k.s32_to_f32 = drwav__s32_to_f32_avx512;
+        k.u8_to_s32  = drwav__u8_to_s32_avx512;
+        k.s16_to_s32 = drwav__s16_to_s32_avx512;
+        k.s24_to_s32 = drwav__s24_to_s32_avx512;
+        k.f32_to_s32 = drwav__f32_to_s32_avx512;
+    }
+#endif
+
+    g_drwavSimdKernels = k;
+    drwav__simd_state_publish();
+    return &g_drwavSimdKernels;
+}
+
+#define DRWAV_SIMD_CONVERT(name, pOut, pIn, sampleCount)    drwav__get_simd_kernels()->name((pOut), (pIn), (sampleCount))
+#else
+#define DRWAV_SIMD_CONVERT(name, pOut, pIn, sampleCount)    0
+#endif  /* DRWAV_SUPPORT_SIMD */
+
+
 
 DRWAV_PRIVATE void drwav__pcm_to_s16(drwav_int16* pOut, const drwav_uint8* pIn, size_t totalSampleCount, unsigned int bytesPerSample)
 {
@@ -6189,7 +6960,7 @@ DRWAV_API void drwav_u8_to_s16(drwav_int16* pOut, const drwav_uint8* pIn, size_t
 {
     int r;
     size_t i;
-    for (i = 0; i < sampleCount; ++i) {
+    for (i = DRWAV_SIMD_CONVERT(u8_to_s16, pOut, pIn, sampleCount); i < sampleCount; ++i) {
         int x = pIn[i];
         r = x << 8;
         r = r - 32768;
@@ -6201,7 +6972,7 @@ DRWAV_API void drwav_s24_to_s16(drwav_int16* pOut, const drwav_uint8* pIn, size_
 {
     int r;
     size_t i;
-    for (i = 0; i < sampleCount; ++i) {
+    for (i = DRWAV_SIMD_CONVERT(s24_to_s16, pOut, pIn, sampleCount); i < sampleCount; ++i) {
         int x = ((int)(((unsigned int)(((const drwav_uint8*)pIn)[i*3+0]) << 8) | ((unsigned int)(((const drwav_uint8*)pIn)[i*3+1]) << 16) | ((unsigned int)(((const drwav_uint8*)pIn)[i*3+2])) << 24)) >> 8;
         r = x >> 8;
         pOut[i] = (short)r;
@@ -6212,7 +6983,7 @@ DRWAV_API void drwav_s32_to_s16(drwav_int16* pOut, const drwav_int32* pIn, size_
 {
     int r;
     size_t i;
-    for (i = 0; i < sampleCount; ++i) {
+    for (i = DRWAV_SIMD_CONVERT(s32_to_s16, pOut, pIn, sampleCount); i < sampleCount; ++i) {
         int x = pIn[i];
         r = x >> 16;
         pOut[i] = (short)r;
@@ -6223,7 +6994,7 @@ DRWAV_API void drwav_f32_to_s16(drwav_int16* pOut, const float* pIn, size_t samp
 {
     int r;
     size_t i;
-    for (i = 0; i < sampleCount; ++i) {
+    for (i = DRWAV_SIMD_CONVERT(f32_to_s16, pOut, pIn, sampleCount); i < sampleCount; ++i) {
         float x = pIn[i];
         float c;
         c = ((x < -1) ? -1 : ((x > 1) ? 1 : x));
@@ -6585,7 +7356,10 @@ DRWAV_API void drwav_u8_to_f32(float* pOut, const drwav_uint8* pIn, size_t sampl
         *pOut++ = (pIn[i] / 256.0f) * 2 - 1;
     }
 #else
-    for (i = 0; i < sampleCount; ++i) {
+    i = DRWAV_SIMD_CONVERT(u8_to_f32, pOut, pIn, sampleCount);
+    pOut += i;
+
+    for (; i < sampleCount; ++i) {
         float x = pIn[i];
         x = x * 0.00784313725490196078f;    /* 0..255 to 0..2 */
         x = x - 1;                          /* 0..2 to -1..1 */
@@ -6603,7 +7377,10 @@ DRWAV_API void drwav_s16_to_f32(float* pOut, const drwav_int16* pIn, size_t samp
         return;
     }
 
-    for (i = 0; i < sampleCount; ++i) {
+    i = DRWAV_SIMD_CONVERT(s16_to_f32, pOut, pIn, sampleCount);
+    pOut += i;
+
+    for (; i < sampleCount; ++i) {
         *pOut++ = pIn[i] * 0.000030517578125f;
     }
 }
@@ -6616,7 +7393,10 @@ DRWAV_API void drwav_s24_to_f32(float* pOut, const drwav_uint8* pIn, size_t samp
         return;
     }
 
-    for (i = 0; i < sampleCount; ++i) {
+    i = DRWAV_SIMD_CONVERT(s24_to_f32, pOut, pIn, sampleCount);
+    pOut += i;
+
+    for (; i < sampleCount; ++i) {
         double x;
         drwav_uint32 a = ((drwav_uint32)(pIn[i*3+0]) <<  8);
         drwav_uint32 b = ((drwav_uint32)(pIn[i*3+1]) << 16);
@@ -6634,7 +7414,10 @@ DRWAV_API void drwav_s32_to_f32(float* pOut, const drwav_int32* pIn, size_t samp
         return;
     }
 
-    for (i = 0; i < sampleCount; ++i) {
+    i = DRWAV_SIMD_CONVERT(s32_to_f32, pOut, pIn, sampleCount);
+    pOut += i;
+
+    for (; i < sampleCount; ++i) {
         *pOut++ = (float)(pIn[i] / 2147483648.0);
     }
 }
@@ -6986,7 +7769,10 @@ DRWAV_API void drwav_u8_to_s32(drwav_int32* pOut, const drwav_uint8* pIn, size_t
         return;
     }
 
-    for (i = 0; i < sampleCount; ++i) {
+    i = DRWAV_SIMD_CONVERT(u8_to_s32, pOut, pIn, sampleCount);
+    pOut += i;
+
+    for (; i < sampleCount; ++i) {
         *pOut++ = ((int)pIn[i] - 128) << 24;
     }
 }
@@ -6999,7 +7785,10 @@ DRWAV_API void drwav_s16_to_s32(drwav_int32* pOut, const drwav_int16* pIn, size_
         return;
     }
 
-    for (i = 0; i < sampleCount; ++i) {
+    i = DRWAV_SIMD_CONVERT(s16_to_s32, pOut, pIn, sampleCount);
+    pOut += i;
+
+    for (; i < sampleCount; ++i) {
         *pOut++ = pIn[i] << 16;
     }
 }
@@ -7012,7 +7801,10 @@ DRWAV_API void drwav_s24_to_s32(drwav_int32* pOut, const drwav_uint8* pIn, size_
         return;
     }
 
-    for (i = 0; i < sampleCount; ++i) {
+    i = DRWAV_SIMD_CONVERT(s24_to_s32, pOut, pIn, sampleCount);
+    pOut += i;
+
+    for (; i < sampleCount; ++i) {
         unsigned int s0 = pIn[i*3 + 0];
         unsigned int s1 = pIn[i*3 + 1];
         unsigned int s2 = pIn[i*3 + 2];
@@ -7030,7 +7822,10 @@ DRWAV_API void drwav_f32_to_s32(drwav_int32* pOut, const float* pIn, size_t samp
         return;
     }
 
-    for (i = 0; i < sampleCount; ++i) {
+    i = DRWAV_SIMD_CONVERT(f32_to_s32, pOut, pIn, sampleCount);
+    pOut += i;
+
+    for (; i < sampleCount; ++i) {
         *pOut++ = (drwav_int32)(2147483648.0 * pIn[i]);
     }
 }
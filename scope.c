@@ -1,204 +1,2238 @@
 #define _USE_MATH_DEFINES 1
-#define DR_WAV_IMPLEMENTATION 1
 
 #include <assert.h>
 #include <glad/gl.h>
 #include <GLFW/glfw3.h>
-#include <math.h>
-#include <portaudio.h>
 #include <stdarg.h>
-#include <stddef.h>
 #include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
 
-#include "dr_wav.h"
+#include "scope_core.h"
 
 #define TOSTRING1(x) #x
 #define TOSTRING2(x) TOSTRING1(x)
 
-#define BUF_SSBO 0 /* SSBO  - wave data     */
-#define BUF_UNIF 1 /* UBO   - common data   */
-#define NUM_BUFS 2
+#define BUF_UNIF 0 /* UBO   - common data   */
+#define BUF_SPEC 1 /* SSBO  - spectrum      */
+#define BUF_FFTI 2 /* SSBO  - FFT input     */
+#define BUF_FFTW 3 /* SSBO  - FFT work      */
+#define BUF_FFTB 4 /* SSBO  - FFT bins      */
+#define BUF_HUD  5 /* SSBO  - HUD text      */
+#define NUM_BUFS 6
 
-typedef double  vec2d_t[2];
-typedef float   vec2f_t[2];
-typedef float   vec3f_t[3];
-typedef float   vec4f_t[4];
+#define TRACK_SLICE 1048576 /* bytes streamed into the next GPU chunk per frame */
 
-struct ubo_data {
-    vec4f_t xyz_color;
-    vec4f_t x_dt_yz_screen;
+#define MIX_BLOCK 4096 /* samples widened to float at once */
+
+#define SPECTRUM_FLOOR 120.0f /* dB below full scale at the bottom */
+#define SPECTRUM_FALL 20.0f   /* dB per second the peak hold drops */
+
+#define FFT_GROUP 64 /* compute shader invocations per work group */
+
+#define PHOSPHOR_PERSISTENCE 0.1 /* seconds for the hits to fall to 1/e */
+
+#define WATERFALL_ROWS 512   /* log frequency bins per column */
+#define WATERFALL_DEPTH 1024 /* columns kept on screen        */
+#define MIN_HOP 256
+
+#define WAVE_SEGMENTS 3 /* frames the wave table can be in flight */
+
+#define AUDIO_OUT_FRAMES 262144 /* frames queued for the audio writer */
+
+#define PROFILE_FRAMES 256 /* frames the HUD statistics go over */
+#define PROFILE_QUERIES 4  /* timer queries in flight           */
+#define HUD_COLUMNS 32
+#define HUD_ROWS 14      /* timings, drops, audio, trigger, FFT */
+#define HUD_REFRESH 0.25 /* seconds between updates of the text */
+
+/* GPU mode keeps the samples themselves in an SSBO,
+ * either the whole track or two chunks used as a ring
+ * when it doesn't fit in a single storage block. The
+ * next chunk is streamed in a slice at a time, so
+ * `filled` says how many of its frames are there. */
+struct gpu_track {
+    GLuint buffer;
+    size_t chunk;
+    size_t resident[2];
+    size_t filled[2];
+};
+
+/* The wave table lives in a persistently mapped
+ * buffer split into segments; the CPU fills one while
+ * the GPU may still be reading the others, and a fence
+ * per segment says when it can be written again. */
+struct wave_ring {
+    GLuint buffer;
+    float *map;
+    size_t size;   /* bytes the shaders see */
+    size_t stride; /* bytes between segments */
+    size_t segment;
+    GLsync fences[WAVE_SEGMENTS];
+};
+
+enum trigger_mode {
+    TRIGGER_OFF,
+    TRIGGER_AUTO,   /* free-run when nothing triggers for a while */
+    TRIGGER_NORMAL, /* hold the last trigger forever              */
+    TRIGGER_SINGLE, /* trigger once, then hold until re-armed     */
+    NUM_TRIGGER_MODES
 };
 
-struct pa_state {
-    size_t sample_rate;
-    size_t num_samples;
-    size_t num_channels;
-    size_t position;
-    float *samples;
+struct trigger {
+    enum trigger_mode mode;
+    int falling;
+    int armed;
+    float level;
+    float hysteresis;
+    size_t holdoff;
+    size_t last; /* SIZE_MAX until something triggers */
+
+    /* The mix, negated for falling edges, of frames
+     * [first, mixed) is kept in `scratch` from one
+     * frame to the next; it has room for two spans
+     * and slides back when full. Crossings in [lo,
+     * scanned) were all turned down by the last scans
+     * at the same level and rearm point, except for
+     * `found`, which rearmed at `found_rearm`. */
+    float *scratch;
+    size_t first;
+    size_t mixed;
+    float sign;
+    size_t lo;
+    size_t scanned;
+    size_t found;
+    size_t found_rearm;
+    float scan_level;
+    float scan_rearm;
+};
+
+enum spectrum_view {
+    SPECTRUM_HIDDEN,
+    SPECTRUM_LINE,
+    SPECTRUM_WATERFALL,
+    NUM_SPECTRUM_VIEWS
+};
+
+enum fft_window {
+    WINDOW_HANN,
+    WINDOW_BLACKMAN_HARRIS,
+    NUM_WINDOWS
+};
+
+/* Everything is sized for the largest transform and
+ * the widest screen up front, changing the size or
+ * the window never allocates. A real transform of
+ * 1 << bits points is done as a complex one of half
+ * that size, ping-ponging between re/im[0] and [1]. */
+struct spectrum {
+    size_t bits;
+    enum fft_window window;
+    int stale; /* window and peaks need a reset */
+    float *coeffs;
+    float *tw_re;  /* W_n^p at [n / 2 + p] for every n */
+    float *tw_im;
+    float *re[2];
+    float *im[2];
+    float *db;
+    float *columns; /* levels, then the peak hold */
+    size_t max_columns;
+    size_t num_columns;
+};
+
+/* The spectrogram is a ring of STFT columns, one
+ * per `hop` frames. Columns are texture rows so that
+ * a run of new ones is a single contiguous upload,
+ * the oldest is at `next`. */
+struct waterfall {
+    GLuint texture;
+    size_t next;
+    size_t hop;
+    size_t last; /* frame the newest column ends at */
+    float *staging;
+};
+
+/* Headless mode draws into a framebuffer of its own
+ * and streams it out as YUV4MPEG2. Each frame is read
+ * into one of two pixel buffers and only converted a
+ * frame later, so the copy never stalls the GPU. */
+struct video_out {
+    FILE *file;
+    GLuint framebuffer;
+    GLuint color;
+    GLuint pixels[2];
+    size_t width;
+    size_t height;
+    size_t frames;
+    unsigned char *yuv;
+};
+
+/* The audio of a headless render goes through a ring
+ * to a thread of its own that writes the file. Frames
+ * [tail, head) are queued; only the render thread
+ * moves head and only the writer moves tail. */
+struct audio_out {
+    drwav wav;
+    float *frames;
+    size_t mask;
+    size_t channels;
+    size_t position; /* next frame to be queued */
+    atomic_size_t head;
+    atomic_size_t tail;
+    atomic_bool done;
+    atomic_bool failed; /* the writer gave up on a short write */
+    thrd_t thread;
+};
+
+enum profile_timing {
+    TIMING_FRAME,  /* from the start of one frame to the next */
+    TIMING_GPU,    /* GL work of a frame, from a timer query  */
+    TIMING_FILL,   /* trigger search and the wave table       */
+    TIMING_UPLOAD, /* waiting on the wave ring, the uniforms  */
+    TIMING_SWAP,
+    TIMING_OTHER,  /* whatever else the loop spends time on   */
+    NUM_TIMINGS
+};
+
+/* Rolling timings in milliseconds. GPU times come
+ * from a ring of timer queries that are only read
+ * once their results are available, a few frames
+ * late; while all of them are pending a frame goes
+ * unmeasured rather than waiting. CPU time between
+ * two marks counts toward the second one's phase. */
+struct profile {
+    GLuint queries[PROFILE_QUERIES];
+    size_t issued;
+    size_t collected;
+    int querying;
+    float history[NUM_TIMINGS][PROFILE_FRAMES];
+    size_t counts[NUM_TIMINGS];
+    double phases[NUM_TIMINGS]; /* seconds so far this frame */
+    double start;
+    double mark;
+    double period; /* between swaps, 0 when not synced */
+    size_t frames;
+    size_t dropped;
+    int shown;
+    double refresh; /* when the HUD text is due */
+    GLuint text[HUD_COLUMNS * HUD_ROWS];
 };
 
-static char g_logbuf[4096] = { 0 };
 static PaStream *g_stream = NULL;
 static GLFWwindow *g_window = NULL;
 static GLuint g_program = 0;
 static GLuint g_bufs[NUM_BUFS] = { 0 };
 static GLuint g_vao = 0;
-static struct pa_state g_state = { 0 };
-static vec2f_t *g_wave_table = NULL;
-static size_t g_wave_table_size = 0;
+static struct trigger g_trigger = { 0 };
+static GLuint g_track_program = 0;
+static GLuint g_xy_program = 0;
+static int g_xy = 0;
+static GLuint g_phosphor_program = 0;
+static GLuint g_tone_program = 0;
+static GLuint g_phosphor_image = 0;
+static int g_phosphor = 0;
+static struct spectrum g_spectrum = { 0 };
+static GLuint g_spectrum_program = 0;
+static GLuint g_fft_program = 0;
+static int g_gpu_fft = 0;
+static enum spectrum_view g_spectrum_view = SPECTRUM_HIDDEN;
+static struct waterfall g_waterfall = { 0 };
+static GLuint g_waterfall_program = 0;
+static struct gpu_track g_track = { 0 };
+static struct wave_ring g_wave_ring = { 0 };
+static float g_line_width = 2.0f;
+static struct profile g_profile = { 0 };
+static GLuint g_hud_program = 0;
+
+#define UBO_SRC                                                         \
+    "layout(binding = 1, std140) uniform __ubo_1 {                      \n" \
+    "   vec4 xyz_color;                                                 \n" \
+    "   vec4 x_dt_yz_screen;                                            \n" \
+    "   uvec4 track;                                                    \n" \
+    "   uvec4 lanes;                                                    \n" \
+    "   vec4 wave;                                                      \n" \
+    "   uvec4 storage;                                                  \n" \
+    "   vec4 waterfall;                                                 \n" \
+    "   vec4 line;                                                      \n" \
+    "   vec4 lane_color[" TOSTRING2(MAX_LANES) "];                      \n" \
+    "};                                                                 \n"
 
+/* Frames as they are stored on the host, in the
+ * order of enum sample_format: floats, or pairs of
+ * 16-bit integers or half floats in a word. */
+#define SAMPLES_SRC                                                     \
+    "layout(binding = 0, std430) buffer __ssbo_0 { uint samples[]; };   \n" \
+    "uint sample_count(uint format)                                     \n" \
+    "{                                                                  \n" \
+    "   return uint(samples.length()) * (format == 0u ? 1u : 2u);       \n" \
+    "}                                                                  \n" \
+    "float sample_load(uint i, uint format)                             \n" \
+    "{                                                                  \n" \
+    "   if(format == 0u)                                                \n" \
+    "       return uintBitsToFloat(samples[i]);                         \n" \
+    "   uint w = samples[i / 2u] >> (i % 2u * 16u);                     \n" \
+    "   if(format == 2u)                                                \n" \
+    "       return unpackHalf2x16(w).x;                                 \n" \
+    "   return float(bitfieldExtract(int(w), 0, 16)) / 32768.0;         \n" \
+    "}                                                                  \n"
+
+/* Every segment of a line strip becomes a quad of
+ * two triangles, six vertices per segment, offset
+ * in pixels so that the width doesn't depend on the
+ * slope. The shader using it provides point(), the
+ * clip space position of the i-th vertex of a lane,
+ * and tint(). The quads are a pixel wider on each
+ * side for the fragment shader to fade out and run
+ * half a width past both ends to close the joints. */
+#define LINE_SRC                                                        \
+    "layout(location = 0) flat out vec3 color;                          \n" \
+    "layout(location = 1) out float edge;                               \n" \
+    "void main(void)                                                    \n" \
+    "{                                                                  \n" \
+    "   uint i = uint(gl_VertexID) / 6u;                                \n" \
+    "   uint corner = uint(gl_VertexID) % 6u;                           \n" \
+    "   uint lane = uint(gl_InstanceID);                                \n" \
+    "   vec2 screen = x_dt_yz_screen.yz;                                \n" \
+    "   vec2 a = (point(i, lane) * 0.5 + 0.5) * screen;                 \n" \
+    "   vec2 b = (point(i + 1u, lane) * 0.5 + 0.5) * screen;            \n" \
+    "   vec2 d = b - a;                                                 \n" \
+    "   vec2 dir = dot(d, d) > 1e-8 ? normalize(d) : vec2(1.0, 0.0);    \n" \
+    "   float side = (0x2Cu >> corner & 1u) != 0u ? 1.0 : -1.0;         \n" \
+    "   float end = float(0x32u >> corner & 1u);                        \n" \
+    "   float w = line.x * 0.5 + 1.0;                                   \n" \
+    "   vec2 p = mix(a, b, end) + vec2(-dir.y, dir.x) * side * w;       \n" \
+    "   p += dir * (end * 2.0 - 1.0) * line.x * 0.5;                    \n" \
+    "   color = tint(lane);                                             \n" \
+    "   edge = side * w;                                                \n" \
+    "   gl_Position = vec4(p / screen * 2.0 - 1.0, 0.0, 1.0);           \n" \
+    "}                                                                  \n"
+
+/* One instance per lane, lanes are stacked top to
+ * bottom and squeezed to fit the screen. Only y comes
+ * from the wave table, vertices are evenly spaced in
+ * x starting after the lead-in and again from the
+ * start of the RMS band; the lead-in begins at the
+ * left edge. */
 static const char *vert_src =
     "#version 450 core                                                  \n"
-    "layout(binding = 0, std430) buffer __ssbo_0 { vec2 signal[]; };    \n"
+    "layout(binding = 0, std430) buffer __ssbo_0 { float signal[]; };   \n"
+    UBO_SRC
+    "vec2 point(uint i, uint lane)                                      \n"
+    "{                                                                  \n"
+    "   uint k = i < lanes.z ? i : i - lanes.z + lanes.w;               \n"
+    "   float x = wave.x + float(k) * wave.y;                           \n"
+    "   float y = signal[lane * lanes.y + i];                           \n"
+    "   if(k == 0u && lanes.w > 0u)                                     \n"
+    "       x = -1.0;                                                   \n"
+    "   return vec2(x, y / float(lanes.x) + lane_color[lane].w);        \n"
+    "}                                                                  \n"
+    "vec3 tint(uint lane)                                               \n"
+    "{                                                                  \n"
+    "   return xyz_color.xyz * lane_color[lane].xyz;                    \n"
+    "}                                                                  \n"
+    LINE_SRC;
+
+static const char *track_vert_src =
+    "#version 450 core                                                  \n"
+    SAMPLES_SRC
+    UBO_SRC
+    "vec2 point(uint i, uint lane)                                      \n"
+    "{                                                                  \n"
+    "   uint frames = sample_count(storage.x) / track.w;                \n"
+    "   float x = float(i) / float(track.z) * 2.0 - 1.0;                \n"
+    "   float y = 0.0;                                                  \n"
+    "   if(i >= track.y) {                                              \n"
+    "       uint base = ((track.x + i - track.y) % frames) * track.w;   \n"
+    "       if(lanes.x > 1u) {                                          \n"
+    "           y = sample_load(base + lane, storage.x);                \n"
+    "       } else {                                                    \n"
+    "           for(uint j = 0u; j < track.w; j++)                      \n"
+    "               y += sample_load(base + j, storage.x);              \n"
+    "           y /= float(track.w);                                    \n"
+    "       }                                                           \n"
+    "   }                                                               \n"
+    "   return vec2(x, y / float(lanes.x) + lane_color[lane].w);        \n"
+    "}                                                                  \n"
+    "vec3 tint(uint lane)                                               \n"
+    "{                                                                  \n"
+    "   return xyz_color.xyz * lane_color[lane].xyz;                    \n"
+    "}                                                                  \n"
+    LINE_SRC;
+
+/* Levels and the peak hold after them, one value
+ * per pixel column, already in clip space. */
+static const char *spectrum_vert_src =
+    "#version 450 core                                                  \n"
+    "layout(binding = 0, std430) buffer __ssbo_0 { float spectrum[]; }; \n"
+    UBO_SRC
+    "vec2 point(uint i, uint lane)                                      \n"
+    "{                                                                  \n"
+    "   uint columns = uint(spectrum.length()) / 2u;                    \n"
+    "   float x = float(i % columns) / float(columns - 1u) * 2.0 - 1.0; \n"
+    "   return vec2(x, spectrum[i]);                                    \n"
+    "}                                                                  \n"
+    "vec3 tint(uint lane)                                               \n"
+    "{                                                                  \n"
+    "   return xyz_color.xyz;                                           \n"
+    "}                                                                  \n"
+    LINE_SRC;
+
+/* The same analysis as spectrum_analyze and
+ * spectrum_update, one dispatch per step: load the
+ * windowed mix as N/2 complex points, radix-4
+ * Stockham passes (one radix-2 pass at the end when
+ * the count is odd) ping-ponging between the halves
+ * of `work`, split the real transform into dB bins
+ * and resample those onto the columns of the view.
+ * `pass` is the step, n, s and the source half,
+ * `shape` the point count, window, channel count and
+ * column count, `source` the first frame, the
+ * number of frames there are and their sample
+ * format, `scale` the sample
+ * rate, how far the peaks fall and whether they
+ * have to be reset. */
+static const char *fft_comp_src =
+    "#version 450 core                                                  \n"
+    "layout(local_size_x = " TOSTRING2(FFT_GROUP) ") in;                \n"
+    SAMPLES_SRC
+    "layout(binding = 2, std430) buffer __ssbo_2 { vec2 work[]; };      \n"
+    "layout(binding = 3, std430) buffer __ssbo_3 { float bins[]; };     \n"
+    "layout(binding = 4, std430) buffer __ssbo_4 { float spectrum[]; }; \n"
+    "layout(location = 0) uniform uvec4 pass;                           \n"
+    "layout(location = 1) uniform uvec4 shape;                          \n"
+    "layout(location = 2) uniform ivec4 source;                         \n"
+    "layout(location = 3) uniform vec4 scale;                           \n"
+    "const float PI = 3.14159265358979;                                 \n"
+    "const uint MAX_POINTS = 1u << (" TOSTRING2(FFT_MAX_BITS) "u - 1u); \n"
+    "const float FLOOR = " TOSTRING2(SPECTRUM_FLOOR) ";                 \n"
+    "vec2 twiddle(uint k, uint n)                                       \n"
+    "{                                                                  \n"
+    "   float a = -2.0 * PI * float(k) / float(n);                      \n"
+    "   return vec2(cos(a), sin(a));                                    \n"
+    "}                                                                  \n"
+    "vec2 cmul(vec2 a, vec2 b)                                          \n"
+    "{                                                                  \n"
+    "   return vec2(a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x);      \n"
+    "}                                                                  \n"
+    "float windowed(uint i)                                             \n"
+    "{                                                                  \n"
+    "   int frame = source.x + int(i);                                  \n"
+    "   float n = float(shape.x * 2u);                                  \n"
+    "   float x = 2.0 * PI * float(i) / n;                              \n"
+    "   float w = (0.5 - 0.5 * cos(x)) * 4.0 / n;                       \n"
+    "   float sum = 0.0;                                                \n"
+    "   uint format = uint(source.z);                                   \n"
+    "   if(shape.y == 1u)                                               \n"
+    "       w = (0.35875 - 0.48829 * cos(x) + 0.14128 * cos(2.0 * x)    \n"
+    "           - 0.01168 * cos(3.0 * x)) * 2.0 / (0.35875 * n);        \n"
+    "   if(frame < 0 || frame >= source.y)                              \n"
+    "       return 0.0;                                                 \n"
+    "   for(uint j = 0u; j < shape.z; j++)                              \n"
+    "       sum += sample_load(uint(frame) * shape.z + j, format);      \n"
+    "   return sum / float(shape.z) * w;                                \n"
+    "}                                                                  \n"
+    "void main(void)                                                    \n"
+    "{                                                                  \n"
+    "   uint g = gl_GlobalInvocationID.x;                               \n"
+    "   uint m = shape.x;                                               \n"
+    "   uint x = pass.w * MAX_POINTS;                                   \n"
+    "   uint y = (1u - pass.w) * MAX_POINTS;                            \n"
+    "   uint n = pass.y, s = max(pass.z, 1u);                           \n"
+    "   uint p = g / s, q = g % s;                                      \n"
+    "   if(pass.x == 0u && g < m)                                       \n"
+    "       work[g] = vec2(windowed(g * 2u), windowed(g * 2u + 1u));    \n"
+    "   if(pass.x == 1u && g < m / 4u) {                                \n"
+    "       vec2 a = work[x + q + s * p];                               \n"
+    "       vec2 b = work[x + q + s * (p + n / 4u)];                    \n"
+    "       vec2 c = work[x + q + s * (p + n / 2u)];                    \n"
+    "       vec2 d = work[x + q + s * (p + n / 4u * 3u)];               \n"
+    "       vec2 apc = a + c, amc = a - c, bpd = b + d;                 \n"
+    "       vec2 jbmd = vec2(d.y - b.y, b.x - d.x);                     \n"
+    "       vec2 w1 = twiddle(p, n);                                    \n"
+    "       vec2 w2 = twiddle(p * 2u, n);                               \n"
+    "       vec2 w3 = twiddle(p * 3u, n);                               \n"
+    "       work[y + q + s * (p * 4u)] = apc + bpd;                     \n"
+    "       work[y + q + s * (p * 4u + 1u)] = cmul(amc - jbmd, w1);     \n"
+    "       work[y + q + s * (p * 4u + 2u)] = cmul(apc - bpd, w2);      \n"
+    "       work[y + q + s * (p * 4u + 3u)] = cmul(amc + jbmd, w3);     \n"
+    "   }                                                               \n"
+    "   if(pass.x == 2u && g < m / 2u) {                                \n"
+    "       vec2 a = work[x + q + s * p];                               \n"
+    "       vec2 b = work[x + q + s * (p + n / 2u)];                    \n"
+    "       vec2 w1 = twiddle(p, n);                                    \n"
+    "       work[y + q + s * (p * 2u)] = a + b;                         \n"
+    "       work[y + q + s * (p * 2u + 1u)] = cmul(a - b, w1);          \n"
+    "   }                                                               \n"
+    "   if(pass.x == 3u && g <= m) {                                    \n"
+    "       vec2 a = work[x + g % m];                                   \n"
+    "       vec2 b = work[x + (m - g) % m] * vec2(1.0, -1.0);           \n"
+    "       vec2 e = (a + b) * 0.5;                                     \n"
+    "       vec2 o = vec2(a.y - b.y, b.x - a.x) * 0.5;                  \n"
+    "       vec2 v = e + cmul(o, twiddle(g, m * 2u));                   \n"
+    "       bins[g] = 10.0 * log(dot(v, v) + 1e-20) / log(10.0);        \n"
+    "   }                                                               \n"
+    "   if(pass.x == 4u && g < shape.w) {                               \n"
+    "       float top = scale.x * 0.5 / 20.0, cols = float(shape.w);    \n"
+    "       float bin = float(m * 2u) / scale.x;                        \n"
+    "       float b0 = 20.0 * pow(top, float(g) / cols) * bin;          \n"
+    "       float b1 = 20.0 * pow(top, float(g + 1u) / cols) * bin;     \n"
+    "       uint lo = uint(ceil(b0)), hi = min(uint(b1), m);            \n"
+    "       float db = bins[min(lo, m)];                                \n"
+    "       if(lo <= hi) {                                              \n"
+    "           for(uint k = lo + 1u; k <= hi; k++)                     \n"
+    "               db = max(db, bins[k]);                              \n"
+    "       } else {                                                    \n"
+    "           float c = (b0 + b1) * 0.5;                              \n"
+    "           uint k = min(uint(c), m - 1u);                          \n"
+    "           db = mix(bins[k], bins[k + 1u], c - float(k));          \n"
+    "       }                                                           \n"
+    "       float level = max(db / FLOOR + 1.0, 0.0) * 2.0 - 1.0;       \n"
+    "       float peak = spectrum[shape.w + g] - scale.y;               \n"
+    "       spectrum[g] = level;                                        \n"
+    "       if(scale.z > 0.0 || peak < level)                           \n"
+    "           peak = level;                                           \n"
+    "       spectrum[shape.w + g] = peak;                               \n"
+    "   }                                                               \n"
+    "}                                                                  \n";
+
+/* Phosphor mode, step 0 fades the hits by `fade.x`,
+ * step 1 draws every segment between two frames of
+ * the window into them, one invocation per segment
+ * and lane. Cost follows the number of frames rather
+ * than how often the same pixels get drawn over. */
+static const char *phosphor_comp_src =
+    "#version 450 core                                                  \n"
+    "layout(local_size_x = " TOSTRING2(FFT_GROUP) ") in;                \n"
+    SAMPLES_SRC
+    UBO_SRC
+    "layout(binding = 0, r32ui) uniform uimage2D hits;                  \n"
+    "layout(location = 0) uniform uvec4 pass;                           \n"
+    "layout(location = 1) uniform vec4 fade;                            \n"
+    "float sample_at(uint i, uint lane)                                 \n"
+    "{                                                                  \n"
+    "   uint frames = sample_count(storage.x) / track.w;                \n"
+    "   uint base = ((track.x + i - track.y) % frames) * track.w;       \n"
+    "   float y = 0.0;                                                  \n"
+    "   if(i < track.y)                                                 \n"
+    "       return 0.0;                                                 \n"
+    "   if(lanes.x > 1u)                                                \n"
+    "       return sample_load(base + lane, storage.x);                 \n"
+    "   for(uint j = 0u; j < track.w; j++)                              \n"
+    "       y += sample_load(base + j, storage.x);                      \n"
+    "   return y / float(track.w);                                      \n"
+    "}                                                                  \n"
+    "vec2 pixel_at(uint i, uint lane)                                   \n"
+    "{                                                                  \n"
+    "   float x = float(i) / float(track.z);                            \n"
+    "   float y = sample_at(i, lane) / float(lanes.x);                  \n"
+    "   y = (y + lane_color[lane].w) * 0.5 + 0.5;                       \n"
+    "   return vec2(x, y) * x_dt_yz_screen.yz;                          \n"
+    "}                                                                  \n"
+    "void main(void)                                                    \n"
+    "{                                                                  \n"
+    "   uint g = gl_GlobalInvocationID.x;                               \n"
+    "   uint lane = gl_GlobalInvocationID.y;                            \n"
+    "   ivec2 size = min(ivec2(x_dt_yz_screen.yz), imageSize(hits));    \n"
+    "   if(pass.x == 0u && g < uint(size.x * size.y)) {                 \n"
+    "       ivec2 p = ivec2(int(g) % size.x, int(g) / size.x);          \n"
+    "       uint v = imageLoad(hits, p).x;                              \n"
+    "       imageStore(hits, p, uvec4(uint(float(v) * fade.x)));        \n"
+    "   }                                                               \n"
+    "   if(pass.x == 1u && g + 1u < track.z) {                          \n"
+    "       vec2 a = pixel_at(g, lane);                                 \n"
+    "       vec2 b = pixel_at(g + 1u, lane);                            \n"
+    "       vec2 d = abs(b - a);                                        \n"
+    "       uint steps = min(uint(max(d.x, d.y)) + 1u, 4096u);          \n"
+    "       for(uint k = 0u; k < steps; k++) {                          \n"
+    "           ivec2 p = ivec2(mix(a, b, float(k) / float(steps)));    \n"
+    "           if(all(lessThan(uvec2(p), uvec2(size))))                \n"
+    "               imageAtomicAdd(hits, p, 1u);                        \n"
+    "       }                                                           \n"
+    "   }                                                               \n"
+    "}                                                                  \n";
+
+/* Hits go on a log scale up to `tone.x`. */
+static const char *phosphor_frag_src =
+    "#version 450 core                                                  \n"
+    UBO_SRC
+    "layout(binding = 0, r32ui) uniform readonly uimage2D hits;         \n"
+    "layout(location = 0) uniform vec4 tone;                            \n"
+    "layout(location = 0) in vec2 uv;                                   \n"
+    "layout(location = 0) out vec4 target;                              \n"
+    "void main(void)                                                    \n"
+    "{                                                                  \n"
+    "   uint v = imageLoad(hits, ivec2(uv * x_dt_yz_screen.yz)).x;      \n"
+    "   float t = log(1.0 + float(v)) / log(1.0 + tone.x);              \n"
+    "   target = vec4(xyz_color.xyz * sqrt(clamp(t, 0.0, 1.0)), 1.0);   \n"
+    "}                                                                  \n";
+
+static const char *quad_vert_src =
+    "#version 450 core                                                  \n"
+    "layout(location = 0) out vec2 uv;                                  \n"
     "void main(void)                                                    \n"
     "{                                                                  \n"
-    "   gl_Position = vec4(signal[gl_VertexID], 0.0, 1.0);              \n"
+    "   uv = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));     \n"
+    "   gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);                   \n"
     "}                                                                  \n";
 
-static const char *frag_src =
-    "#version 450 core                                                  \n"
-    "layout(binding = 1, std140) uniform __ubo_1 {                      \n"
-    "   vec4 xyz_color;                                                 \n"
-    "   vec4 x_dt_yz_screen;                                            \n"
-    "};                                                                 \n"
-    "layout(location = 0) out vec4 target;                              \n"
-    "void main(void)                                                    \n"
-    "{                                                                  \n"
-    "   target = vec4(xyz_color.xyz, 1.0);                              \n"
-    "}";
+/* Time runs left to right, oldest column first,
+ * frequency bottom to top. */
+static const char *waterfall_frag_src =
+    "#version 450 core                                                  \n"
+    UBO_SRC
+    "layout(binding = 0) uniform sampler2D columns;                     \n"
+    "layout(location = 0) in vec2 uv;                                   \n"
+    "layout(location = 0) out vec4 target;                              \n"
+    "void main(void)                                                    \n"
+    "{                                                                  \n"
+    "   float depth = float(textureSize(columns, 0).y);                 \n"
+    "   float t = waterfall.x + (uv.x * (depth - 1.0) + 0.5) / depth;   \n"
+    "   float v = texture(columns, vec2(uv.y, t)).r;                    \n"
+    "   target = vec4(clamp(v * 2.0 - 0.4, 0.0, 1.0),                   \n"
+    "       clamp(v * 2.5 - 1.4, 0.0, 1.0),                             \n"
+    "       clamp(sin(v * 3.14159) * 0.8 + v * v, 0.0, 1.0), 1.0);      \n"
+    "}";
+
+/* Channel 0 against channel 1 straight from the
+ * interleaved frames, in a square in the middle. */
+static const char *xy_vert_src =
+    "#version 450 core                                                  \n"
+    SAMPLES_SRC
+    UBO_SRC
+    "vec2 point(uint i, uint lane)                                      \n"
+    "{                                                                  \n"
+    "   uint frames = sample_count(storage.x) / track.w;                \n"
+    "   uint base = ((track.x + i - track.y) % frames) * track.w;       \n"
+    "   float aspect = x_dt_yz_screen.z / x_dt_yz_screen.y;             \n"
+    "   float x = sample_load(base, storage.x) * aspect;                \n"
+    "   return vec2(x, sample_load(base + 1u, storage.x));              \n"
+    "}                                                                  \n"
+    "vec3 tint(uint lane)                                               \n"
+    "{                                                                  \n"
+    "   return xyz_color.xyz;                                           \n"
+    "}                                                                  \n"
+    LINE_SRC;
+
+/* Coverage from the distance to the center of the
+ * line, a one pixel ramp at the edges. */
+static const char *frag_src =
+    "#version 450 core                                                  \n"
+    UBO_SRC
+    "layout(location = 0) flat in vec3 color;                           \n"
+    "layout(location = 1) in float edge;                                \n"
+    "layout(location = 0) out vec4 target;                              \n"
+    "void main(void)                                                    \n"
+    "{                                                                  \n"
+    "   float alpha = clamp(line.x * 0.5 + 0.5 - abs(edge), 0.0, 1.0);  \n"
+    "   target = vec4(color, alpha);                                    \n"
+    "}                                                                  \n";
+
+/* A grid of character cells from the top left,
+ * `hud.w` columns of 6x9 font pixels that are `hud.z`
+ * screen pixels each. The strip runs bottom up
+ * while `texel` counts rows down from the top. */
+static const char *hud_vert_src =
+    "#version 450 core                                                  \n"
+    "layout(binding = 0, std430) buffer __ssbo_0 { uint text[]; };      \n"
+    "layout(location = 0) uniform vec4 hud;                             \n"
+    "layout(location = 0) out vec2 texel;                               \n"
+    "layout(location = 1) flat out uint glyph;                          \n"
+    "void main(void)                                                    \n"
+    "{                                                                  \n"
+    "   uint cell = uint(gl_InstanceID);                                \n"
+    "   uint columns = uint(hud.w);                                     \n"
+    "   uint v = uint(gl_VertexID);                                     \n"
+    "   vec2 corner = vec2(float(v & 1u), float(v < 2u));               \n"
+    "   vec2 origin = vec2(uvec2(cell % columns, cell / columns));      \n"
+    "   texel = corner * vec2(6.0, 9.0);                                \n"
+    "   glyph = text[cell];                                             \n"
+    "   vec2 p = (origin * vec2(6.0, 9.0) + texel + 4.0) * hud.z;       \n"
+    "   gl_Position = vec4(p.x / hud.x * 2.0 - 1.0,                     \n"
+    "       1.0 - p.y / hud.y * 2.0, 0.0, 1.0);                         \n"
+    "}                                                                  \n";
+
+/* 5x7 glyphs from the space to Z, four rows to a
+ * word with the leftmost pixel in the lowest bit,
+ * on a dark backdrop that keeps them readable. */
+static const char *hud_frag_src =
+    "#version 450 core                                                  \n"
+    "const uint font[] = uint[](                                        \n"
+    "       0x00000000u, 0x00000000u, 0x04040404u, 0x00040004u,         \n"
+    "       0x000A0A0Au, 0x00000000u, 0x0A1F0A0Au, 0x000A0A1Fu,         \n"
+    "       0x0E051E04u, 0x00040F14u, 0x04081303u, 0x00181902u,         \n"
+    "       0x02050906u, 0x00160915u, 0x00040404u, 0x00000000u,         \n"
+    "       0x02020408u, 0x00080402u, 0x08080402u, 0x00020408u,         \n"
+    "       0x0E150400u, 0x00000415u, 0x1F040400u, 0x00000404u,         \n"
+    "       0x00000000u, 0x00020406u, 0x1F000000u, 0x00000000u,         \n"
+    "       0x00000000u, 0x00060600u, 0x04081000u, 0x00000102u,         \n"
+    "       0x1519110Eu, 0x000E1113u, 0x04040604u, 0x000E0404u,         \n"
+    "       0x0810110Eu, 0x001F0204u, 0x0804081Fu, 0x000E1110u,         \n"
+    "       0x090A0C08u, 0x0008081Fu, 0x100F011Fu, 0x000E1110u,         \n"
+    "       0x0F01020Cu, 0x000E1111u, 0x0408101Fu, 0x00020202u,         \n"
+    "       0x0E11110Eu, 0x000E1111u, 0x1E11110Eu, 0x00060810u,         \n"
+    "       0x00060600u, 0x00000606u, 0x00060600u, 0x00020406u,         \n"
+    "       0x01020408u, 0x00080402u, 0x001F0000u, 0x0000001Fu,         \n"
+    "       0x10080402u, 0x00020408u, 0x0810110Eu, 0x00040004u,         \n"
+    "       0x1610110Eu, 0x000E1515u, 0x1F11110Eu, 0x00111111u,         \n"
+    "       0x0F11110Fu, 0x000F1111u, 0x0101110Eu, 0x000E1101u,         \n"
+    "       0x11110907u, 0x00070911u, 0x0F01011Fu, 0x001F0101u,         \n"
+    "       0x0F01011Fu, 0x00010101u, 0x1D01110Eu, 0x001E1111u,         \n"
+    "       0x1F111111u, 0x00111111u, 0x0404040Eu, 0x000E0404u,         \n"
+    "       0x0808081Cu, 0x00060908u, 0x03050911u, 0x00110905u,         \n"
+    "       0x01010101u, 0x001F0101u, 0x15151B11u, 0x00111111u,         \n"
+    "       0x15131111u, 0x00111119u, 0x1111110Eu, 0x000E1111u,         \n"
+    "       0x0F11110Fu, 0x00010101u, 0x1111110Eu, 0x00160915u,         \n"
+    "       0x0F11110Fu, 0x00110905u, 0x0E01011Eu, 0x000F1010u,         \n"
+    "       0x0404041Fu, 0x00040404u, 0x11111111u, 0x000E1111u,         \n"
+    "       0x11111111u, 0x00040A11u, 0x15111111u, 0x000A1515u,         \n"
+    "       0x040A1111u, 0x0011110Au, 0x040A1111u, 0x00040404u,         \n"
+    "       0x0408101Fu, 0x001F0102u                                    \n"
+    ");                                                                 \n"
+    "layout(location = 0) in vec2 texel;                                \n"
+    "layout(location = 1) flat in uint glyph;                           \n"
+    "layout(location = 0) out vec4 target;                              \n"
+    "void main(void)                                                    \n"
+    "{                                                                  \n"
+    "   ivec2 p = ivec2(texel) - ivec2(0, 1);                           \n"
+    "   uint bits = 0u;                                                 \n"
+    "   if(p.x < 5 && p.y >= 0 && p.y < 7) {                            \n"
+    "       uvec2 q = uvec2(p);                                         \n"
+    "       bits = font[glyph * 2u + q.y / 4u];                         \n"
+    "       bits >>= q.y % 4u * 8u + q.x;                               \n"
+    "   }                                                               \n"
+    "   float lit = float(bits & 1u);                                   \n"
+    "   target = vec4(vec3(lit), 0.6 + lit * 0.4);                      \n"
+    "}                                                                  \n";
+
+static void on_error(int code, const char *message)
+{
+    lprintf("glfw: %s", message);
+}
+
+static GLuint make_shader(GLenum stage, const char *source)
+{
+    char *info_log;
+    GLint status, length;
+    GLuint shader;
+
+    shader = glCreateShader(stage);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+    if(length > 1) {
+        info_log = safe_malloc((size_t)length + 1);
+        glGetShaderInfoLog(shader, length, NULL, info_log);
+        lprintf("%s", info_log);
+        free(info_log);
+    }
+
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if(!status) {
+        glDeleteShader(shader);
+        return 0;
+    }
+
+    return shader;
+}
+
+static GLuint make_program(GLuint vert, GLuint frag)
+{
+    char *info_log;
+    GLint status, length;
+    GLuint program;
+
+    /* A compute program has no fragment stage. */
+    program = glCreateProgram();
+    glAttachShader(program, vert);
+    if(frag)
+        glAttachShader(program, frag);
+    glLinkProgram(program);
+
+    /* get rid of these */
+    glDeleteShader(vert);
+    glDeleteShader(frag);
+
+    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+    if(length > 1) {
+        info_log = safe_malloc((size_t)length + 1);
+        glGetProgramInfoLog(program, length, NULL, info_log);
+        lprintf("%s", info_log);
+        free(info_log);
+    }
+
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if(!status) {
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    return program;
+}
+
+/* frame_sample for `count` consecutive samples. Half
+ * floats are widened by moving the bits into place
+ * and scaling by 2^112, which gets the subnormals
+ * right too; what lands at 2^16 or above was an
+ * infinity or a NaN and gets the top exponent. */
+static void widen_samples(enum sample_format format, const void *in, size_t count, float *out)
+{
+    size_t i = 0;
+    const int16_t *s16 = in;
+    const uint16_t *f16 = in;
+#ifdef SCOPE_SSE2
+    __m128i v, lo, hi;
+    __m128 f;
+    const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+    const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32(0x77800000));
+    const __m128 infnan = _mm_castsi128_ps(_mm_set1_epi32(0x47800000));
+    const __m128 top = _mm_castsi128_ps(_mm_set1_epi32(0x7f800000));
+    const __m128i mask = _mm_set1_epi32(0x7fff);
+#endif
+
+    switch(format) {
+    case SAMPLE_S16:
+#ifdef SCOPE_SSE2
+        for(; i + 8 <= count; i += 8) {
+            v = _mm_loadu_si128((const __m128i *)(s16 + i));
+            lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+            hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+            _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+            _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+        }
+#endif
+        for(; i < count; i++)
+            out[i] = (float)s16[i] * (1.0f / 32768.0f);
+        break;
+    case SAMPLE_F16:
+#ifdef SCOPE_SSE2
+        for(; i + 4 <= count; i += 4) {
+            v = _mm_loadl_epi64((const __m128i *)(f16 + i));
+            v = _mm_unpacklo_epi16(v, _mm_setzero_si128());
+            f = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(v, mask), 13)), magic);
+            f = _mm_or_ps(f, _mm_and_ps(_mm_cmpge_ps(f, infnan), top));
+            f = _mm_or_ps(f, _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(mask, v), 16)));
+            _mm_storeu_ps(out + i, f);
+        }
+#endif
+        for(; i < count; i++)
+            out[i] = half_to_float(f16[i]);
+        break;
+    default:
+        memcpy(out, in, count * sizeof(float));
+        break;
+    }
+}
+
+/* The mix of `count` frames from `first` on, times
+ * `scale`, into `out`. Frames are widened a block at
+ * a time so the format is only looked at per block. */
+static void mix_frames(const struct pa_state *state, size_t first, size_t count, float scale, float *out)
+{
+    float block[MIX_BLOCK];
+    size_t i, j, n, channels = state->num_channels;
+    const float *x;
+    float sum;
+#ifdef SCOPE_SSE2
+    __m128 a, b, k;
+#endif
+
+    /* No room for a single frame, one at a time then. */
+    if(channels > MIX_BLOCK) {
+        for(i = 0; i < count; i++)
+            out[i] = mix_at(state, first + i) * scale;
+        return;
+    }
+
+    while(count) {
+        n = MIX_BLOCK / channels < count ? MIX_BLOCK / channels : count;
+        if(state->ring && n > state->ring->mask + 1 - (first & state->ring->mask))
+            n = state->ring->mask + 1 - (first & state->ring->mask);
+        widen_samples(state->format, frame_at(state, first), n * channels, block);
+
+        x = block;
+        i = 0;
+#ifdef SCOPE_SSE2
+        k = _mm_set1_ps(scale / (float)channels);
+        if(channels == 1) {
+            for(; i + 4 <= n; i += 4)
+                _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(x + i), k));
+        } else if(channels == 2) {
+            for(; i + 4 <= n; i += 4) {
+                a = _mm_loadu_ps(x + i * 2);
+                b = _mm_loadu_ps(x + i * 2 + 4);
+                a = _mm_add_ps(_mm_shuffle_ps(a, b, 0x88), _mm_shuffle_ps(a, b, 0xdd));
+                _mm_storeu_ps(out + i, _mm_mul_ps(a, k));
+            }
+        }
+#endif
+        for(; i < n; i++) {
+            sum = 0.0f;
+            for(j = 0; j < channels; j++)
+                sum += x[i * channels + j];
+            out[i] = sum / (float)channels * scale;
+        }
+
+        out += n;
+        first += n;
+        count -= n;
+    }
+}
+
+#ifdef SCOPE_SSE2
+static size_t last_lane(int mask)
+{
+    return (mask & 8) ? 3 : (mask & 4) ? 2 : (mask & 2) ? 1 : 0;
+}
+#endif
+
+/* Last i in [lo, hi) where x crosses `level` upwards
+ * between i - 1 and i, SIZE_MAX if there is none.
+ * `lo` has to be at least one. */
+static size_t scan_rising(const float *x, size_t lo, size_t hi, float level)
+{
+    size_t i = hi;
+#ifdef SCOPE_SSE2
+    int mask;
+    const __m128 l = _mm_set1_ps(level);
+    while(i >= lo + 4) {
+        i -= 4;
+        mask = _mm_movemask_ps(_mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(x + i), l), _mm_cmplt_ps(_mm_loadu_ps(x + i - 1), l)));
+        if(mask)
+            return i + last_lane(mask);
+    }
+#endif
+    while(i > lo) {
+        i--;
+        if(x[i] >= level && x[i - 1] < level)
+            return i;
+    }
+
+    return SIZE_MAX;
+}
+
+/* Last i in [lo, hi) where x is at or above `level`
+ * or below `rearm`, SIZE_MAX if there is none. */
+static size_t scan_settle(const float *x, size_t lo, size_t hi, float level, float rearm)
+{
+    size_t i = hi;
+#ifdef SCOPE_SSE2
+    int mask;
+    __m128 v;
+    const __m128 l = _mm_set1_ps(level);
+    const __m128 r = _mm_set1_ps(rearm);
+    while(i >= lo + 4) {
+        i -= 4;
+        v = _mm_loadu_ps(x + i);
+        mask = _mm_movemask_ps(_mm_or_ps(_mm_cmpge_ps(v, l), _mm_cmplt_ps(v, r)));
+        if(mask)
+            return i + last_lane(mask);
+    }
+#endif
+    while(i > lo) {
+        i--;
+        if(x[i] >= level || x[i] < rearm)
+            return i;
+    }
+
+    return SIZE_MAX;
+}
+
+/* Latest frame in [lo, hi) the trigger fires on. A
+ * crossing only counts if the signal went below the
+ * hysteresis band since it was last above the level.
+ * Falling edges are rising edges of the negated mix. */
+static size_t trigger_scan(struct trigger *trigger, size_t lo, size_t hi)
+{
+    size_t i, k, base, from;
+    const float *x;
+    float sign = trigger->falling ? -1.0f : 1.0f;
+    float level = trigger->level * sign;
+    float rearm = level - trigger->hysteresis;
+
+    base = hi > TRIGGER_SPAN ? hi - TRIGGER_SPAN : 0;
+    if(base < frames_base(&g_state))
+        base = frames_base(&g_state);
+    if(lo < base + 1)
+        lo = base + 1;
+    if(lo >= hi)
+        return SIZE_MAX;
+
+    /* Only the frames since the last call get mixed,
+     * unless the window jumped past what is kept. */
+    if(sign != trigger->sign || base < trigger->first || base > trigger->mixed) {
+        trigger->first = trigger->mixed = base;
+        trigger->sign = sign;
+        trigger->scanned = 0;
+        trigger->found = SIZE_MAX;
+    }
+
+    if(hi - trigger->first > 2 * TRIGGER_SPAN) {
+        memmove(trigger->scratch, trigger->scratch + (base - trigger->first), (trigger->mixed - base) * sizeof(float));
+        trigger->first = base;
+    }
+
+    if(hi > trigger->mixed) {
+        mix_frames(&g_state, trigger->mixed, hi - trigger->mixed, sign, trigger->scratch + (trigger->mixed - trigger->first));
+        trigger->mixed = hi;
+    }
+
+    /* Crossings that were turned down stay that way
+     * for as long as the level and the frames before
+     * them don't change. */
+    if(level != trigger->scan_level || rearm != trigger->scan_rearm || lo < trigger->lo || hi < trigger->scanned) {
+        trigger->scanned = 0;
+        trigger->found = SIZE_MAX;
+    }
+
+    from = lo > trigger->scanned ? lo : trigger->scanned;
+    trigger->lo = lo;
+    trigger->scanned = hi;
+    trigger->scan_level = level;
+    trigger->scan_rearm = rearm;
+
+    x = trigger->scratch + (base - trigger->first);
+    i = hi - base;
+    while((i = scan_rising(x, from - base, i, level)) != SIZE_MAX) {
+        k = scan_settle(x, 0, i, level, rearm);
+        if(k == SIZE_MAX)
+            break;
+        if(x[k] < rearm) {
+            trigger->found = base + i;
+            trigger->found_rearm = base + k;
+            return base + i;
+        }
+        i = k + 1;
+    }
+
+    /* The rearm point has to be in the span still. */
+    if(trigger->found != SIZE_MAX && trigger->found >= lo && trigger->found_rearm >= base)
+        return trigger->found;
+    return SIZE_MAX;
+}
+
+/* Where the window of `num_samples` frames should end
+ * for the playhead at `position`: centered on the last
+ * trigger, at the playhead when free-running or
+ * SIZE_MAX when there is nothing to show yet. */
+static size_t trigger_window(struct trigger *trigger, size_t position, size_t num_samples)
+{
+    size_t found, after = num_samples - num_samples / 2;
+
+    if(trigger->mode == TRIGGER_OFF)
+        return position;
+
+    /* Seeking back leaves the last trigger in the future. */
+    if(trigger->last != SIZE_MAX && trigger->last > position)
+        trigger->last = SIZE_MAX;
+
+    if(trigger->mode != TRIGGER_SINGLE || trigger->armed) {
+        found = trigger_scan(trigger, trigger->last != SIZE_MAX ? trigger->last + trigger->holdoff : 0, position > after ? position - after + 1 : 0);
+        if(found != SIZE_MAX) {
+            trigger->last = found;
+            trigger->armed = 0;
+        }
+    }
+
+    if(trigger->last == SIZE_MAX)
+        return trigger->mode == TRIGGER_AUTO ? position : SIZE_MAX;
+    if(trigger->mode == TRIGGER_AUTO && position - trigger->last > after + g_state.sample_rate / 10)
+        return position;
+    return trigger->last + after;
+}
+
+static void spectrum_init(struct spectrum *spec, size_t max_columns)
+{
+    size_t n, p, m;
+    size_t size = (size_t)1 << FFT_MAX_BITS;
+
+    spec->bits = 13;
+    spec->window = WINDOW_HANN;
+    spec->stale = 1;
+    spec->coeffs = safe_malloc(size * sizeof(float));
+    spec->tw_re = safe_malloc(size * sizeof(float));
+    spec->tw_im = safe_malloc(size * sizeof(float));
+    spec->re[0] = safe_malloc(size / 2 * sizeof(float));
+    spec->im[0] = safe_malloc(size / 2 * sizeof(float));
+    spec->re[1] = safe_malloc(size / 2 * sizeof(float));
+    spec->im[1] = safe_malloc(size / 2 * sizeof(float));
+    spec->db = safe_malloc((size / 2 + 1) * sizeof(float));
+    spec->columns = safe_malloc(max_columns * 2 * sizeof(float));
+    spec->max_columns = max_columns;
+    spec->num_columns = 0;
+
+    for(n = 2; n <= size; n *= 2) {
+        m = n / 2;
+        for(p = 0; p < m; p++) {
+            spec->tw_re[m + p] = (float)cos(2.0 * M_PI * (double)p / (double)n);
+            spec->tw_im[m + p] = (float)-sin(2.0 * M_PI * (double)p / (double)n);
+        }
+    }
+}
+
+static void spectrum_shutdown(struct spectrum *spec)
+{
+    free(spec->coeffs);
+    free(spec->tw_re);
+    free(spec->tw_im);
+    free(spec->re[0]);
+    free(spec->im[0]);
+    free(spec->re[1]);
+    free(spec->im[1]);
+    free(spec->db);
+    free(spec->columns);
+    memset(spec, 0, sizeof(struct spectrum));
+}
+
+/* One radix-2 Stockham pass: s interleaved n-point
+ * transforms become 2s interleaved n/2-point ones.
+ * The output is in natural order after the last. */
+static void fft_pass(const struct spectrum *spec, size_t n, size_t s, const float *xr, const float *xi, float *yr, float *yi)
+{
+    size_t p, q;
+    size_t m = n / 2;
+    float ar, ai, br, bi, dr, di;
+    const float *wr = spec->tw_re + m;
+    const float *wi = spec->tw_im + m;
+#ifdef SCOPE_SSE2
+    __m128 vr, vi, sr, si, tr, ti, cr, ci;
+
+    /* The first two passes go across p, four at a
+     * time for s = 1 and two by two for s = 2, the
+     * rest across q where the data is contiguous. */
+    if(s == 1 && m >= 4) {
+        for(p = 0; p < m; p += 4) {
+            vr = _mm_loadu_ps(xr + p);
+            vi = _mm_loadu_ps(xi + p);
+            sr = _mm_add_ps(vr, _mm_loadu_ps(xr + p + m));
+            si = _mm_add_ps(vi, _mm_loadu_ps(xi + p + m));
+            vr = _mm_sub_ps(vr, _mm_loadu_ps(xr + p + m));
+            vi = _mm_sub_ps(vi, _mm_loadu_ps(xi + p + m));
+            cr = _mm_loadu_ps(wr + p);
+            ci = _mm_loadu_ps(wi + p);
+            tr = _mm_sub_ps(_mm_mul_ps(vr, cr), _mm_mul_ps(vi, ci));
+            ti = _mm_add_ps(_mm_mul_ps(vr, ci), _mm_mul_ps(vi, cr));
+            _mm_storeu_ps(yr + p * 2, _mm_unpacklo_ps(sr, tr));
+            _mm_storeu_ps(yr + p * 2 + 4, _mm_unpackhi_ps(sr, tr));
+            _mm_storeu_ps(yi + p * 2, _mm_unpacklo_ps(si, ti));
+            _mm_storeu_ps(yi + p * 2 + 4, _mm_unpackhi_ps(si, ti));
+        }
+
+        return;
+    }
+
+    if(s == 2 && m >= 2) {
+        for(p = 0; p < m; p += 2) {
+            vr = _mm_loadu_ps(xr + p * 2);
+            vi = _mm_loadu_ps(xi + p * 2);
+            sr = _mm_add_ps(vr, _mm_loadu_ps(xr + p * 2 + n));
+            si = _mm_add_ps(vi, _mm_loadu_ps(xi + p * 2 + n));
+            vr = _mm_sub_ps(vr, _mm_loadu_ps(xr + p * 2 + n));
+            vi = _mm_sub_ps(vi, _mm_loadu_ps(xi + p * 2 + n));
+            cr = _mm_set_ps(wr[p + 1], wr[p + 1], wr[p], wr[p]);
+            ci = _mm_set_ps(wi[p + 1], wi[p + 1], wi[p], wi[p]);
+            tr = _mm_sub_ps(_mm_mul_ps(vr, cr), _mm_mul_ps(vi, ci));
+            ti = _mm_add_ps(_mm_mul_ps(vr, ci), _mm_mul_ps(vi, cr));
+            _mm_storeu_ps(yr + p * 4, _mm_movelh_ps(sr, tr));
+            _mm_storeu_ps(yr + p * 4 + 4, _mm_movehl_ps(tr, sr));
+            _mm_storeu_ps(yi + p * 4, _mm_movelh_ps(si, ti));
+            _mm_storeu_ps(yi + p * 4 + 4, _mm_movehl_ps(ti, si));
+        }
+
+        return;
+    }
+
+    if(s >= 4) {
+        for(p = 0; p < m; p++) {
+            cr = _mm_set1_ps(wr[p]);
+            ci = _mm_set1_ps(wi[p]);
+            for(q = 0; q < s; q += 4) {
+                vr = _mm_loadu_ps(xr + q + s * p);
+                vi = _mm_loadu_ps(xi + q + s * p);
+                sr = _mm_add_ps(vr, _mm_loadu_ps(xr + q + s * (p + m)));
+                si = _mm_add_ps(vi, _mm_loadu_ps(xi + q + s * (p + m)));
+                vr = _mm_sub_ps(vr, _mm_loadu_ps(xr + q + s * (p + m)));
+                vi = _mm_sub_ps(vi, _mm_loadu_ps(xi + q + s * (p + m)));
+                _mm_storeu_ps(yr + q + s * p * 2, sr);
+                _mm_storeu_ps(yi + q + s * p * 2, si);
+                _mm_storeu_ps(yr + q + s * (p * 2 + 1), _mm_sub_ps(_mm_mul_ps(vr, cr), _mm_mul_ps(vi, ci)));
+                _mm_storeu_ps(yi + q + s * (p * 2 + 1), _mm_add_ps(_mm_mul_ps(vr, ci), _mm_mul_ps(vi, cr)));
+            }
+        }
+
+        return;
+    }
+#endif
+
+    for(p = 0; p < m; p++) {
+        for(q = 0; q < s; q++) {
+            ar = xr[q + s * p];
+            ai = xi[q + s * p];
+            br = xr[q + s * (p + m)];
+            bi = xi[q + s * (p + m)];
+            dr = ar - br;
+            di = ai - bi;
+            yr[q + s * p * 2] = ar + br;
+            yi[q + s * p * 2] = ai + bi;
+            yr[q + s * (p * 2 + 1)] = dr * wr[p] - di * wi[p];
+            yi[q + s * (p * 2 + 1)] = dr * wi[p] + di * wr[p];
+        }
+    }
+}
+
+/* Transforms the n complex points in re/im[0] and
+ * returns which of the two buffers holds the result. */
+static int fft(struct spectrum *spec, size_t n)
+{
+    int src = 0;
+    size_t s = 1;
+    for(; n > 1; n /= 2, s *= 2) {
+        fft_pass(spec, n, s, spec->re[src], spec->im[src], spec->re[!src], spec->im[!src]);
+        src = !src;
+    }
+
+    return src;
+}
+
+/* The window is scaled so that a full scale sine
+ * right on a bin comes out at 0 dB. */
+static void spectrum_reset(struct spectrum *spec)
+{
+    size_t i;
+    double x, sum = 0.0;
+    size_t n = (size_t)1 << spec->bits;
+
+    for(i = 0; i < n; i++) {
+        x = 2.0 * M_PI * (double)i / (double)n;
+        if(spec->window == WINDOW_BLACKMAN_HARRIS)
+            spec->coeffs[i] = (float)(0.35875 - 0.48829 * cos(x) + 0.14128 * cos(2.0 * x) - 0.01168 * cos(3.0 * x));
+        else
+            spec->coeffs[i] = (float)(0.5 - 0.5 * cos(x));
+        sum += spec->coeffs[i];
+    }
+
+    for(i = 0; i < n; i++)
+        spec->coeffs[i] *= (float)(2.0 / sum);
+    for(i = 0; i < spec->num_columns; i++)
+        spec->columns[spec->num_columns + i] = -1.0f;
+    spec->stale = 0;
+}
+
+static float spectrum_sample(size_t base, int64_t frame)
+{
+    if(frame < (int64_t)base || frame >= (int64_t)g_state.num_samples)
+        return 0.0f;
+    return mix_at(&g_state, (size_t)frame);
+}
+
+/* dB magnitudes of the 1 << bits frames of the mix
+ * right before `position`, from DC to Nyquist. */
+static void spectrum_analyze(struct spectrum *spec, size_t position)
+{
+    size_t i, k, m, n = (size_t)1 << spec->bits;
+    int64_t first = (int64_t)position - (int64_t)n;
+    size_t base = frames_base(&g_state);
+    float ar, ai, br, bi, sr, si, dr, di;
+    int out;
+
+    if(spec->stale)
+        spectrum_reset(spec);
+
+    /* Even frames go in the real part, odd ones in the
+     * imaginary part, the halves are separated below. */
+    m = n / 2;
+    for(i = 0; i < m; i++) {
+        spec->re[0][i] = spectrum_sample(base, first + (int64_t)(i * 2)) * spec->coeffs[i * 2];
+        spec->im[0][i] = spectrum_sample(base, first + (int64_t)(i * 2 + 1)) * spec->coeffs[i * 2 + 1];
+    }
+
+    out = fft(spec, m);
+    for(k = 0; k < m; k++) {
+        ar = spec->re[out][k];
+        ai = spec->im[out][k];
+        br = spec->re[out][(m - k) & (m - 1)];
+        bi = -spec->im[out][(m - k) & (m - 1)];
+        sr = (ar + br) * 0.5f;
+        si = (ai + bi) * 0.5f;
+        dr = (ai - bi) * 0.5f;
+        di = (br - ar) * 0.5f;
+        ar = sr + dr * spec->tw_re[m + k] - di * spec->tw_im[m + k];
+        ai = si + dr * spec->tw_im[m + k] + di * spec->tw_re[m + k];
+        spec->db[k] = 10.0f * log10f(ar * ar + ai * ai + 1e-20f);
+    }
+
+    spec->db[m] = 20.0f * log10f(fabsf(spec->re[out][0] - spec->im[out][0]) + 1e-10f);
+}
+
+/* Resamples the last analysis onto `count` points of
+ * a log frequency axis from 20 Hz to Nyquist, as
+ * levels between 0 at the floor and 1 at full scale.
+ * A point takes the loudest bin it covers or, where
+ * bins are wider than points, the bins around its
+ * center interpolated linearly. */
+static void spectrum_resample(const struct spectrum *spec, float *out, size_t count)
+{
+    size_t i, k, lo, hi;
+    size_t m = ((size_t)1 << spec->bits) / 2;
+    float db;
+    double f, ratio, b0, b1, bin = (double)(m * 2) / (double)g_state.sample_rate;
+
+    ratio = pow((double)g_state.sample_rate / 2.0 / 20.0, 1.0 / (double)count);
+    f = 20.0;
+    for(i = 0; i < count; i++, f *= ratio) {
+        b0 = f * bin;
+        b1 = f * ratio * bin;
+        lo = (size_t)ceil(b0);
+        hi = (size_t)b1 < m ? (size_t)b1 : m;
+        if(lo <= hi) {
+            db = spec->db[lo];
+            for(k = lo + 1; k <= hi; k++)
+                db = spec->db[k] > db ? spec->db[k] : db;
+        } else {
+            b0 = (b0 + b1) * 0.5;
+            k = (size_t)b0 < m ? (size_t)b0 : m - 1;
+            db = spec->db[k] + (spec->db[k + 1] - spec->db[k]) * (float)(b0 - (double)k);
+        }
+
+        out[i] = db / SPECTRUM_FLOOR + 1.0f;
+        if(out[i] < 0.0f)
+            out[i] = 0.0f;
+    }
+}
+
+/* The line view: levels and the peak hold for
+ * `num_columns` pixel columns, in clip space. */
+static void spectrum_update(struct spectrum *spec, size_t position, size_t num_columns, float dt)
+{
+    size_t i;
+    float *levels, *peaks;
+
+    if(num_columns > spec->max_columns)
+        num_columns = spec->max_columns;
+    if(num_columns != spec->num_columns)
+        spec->stale = 1;
+    spec->num_columns = num_columns;
+    if(num_columns < 2)
+        return;
+
+    spectrum_analyze(spec, position);
+
+    levels = spec->columns;
+    peaks = spec->columns + num_columns;
+    spectrum_resample(spec, levels, num_columns);
+    for(i = 0; i < num_columns; i++) {
+        levels[i] = levels[i] * 2.0f - 1.0f;
+        peaks[i] -= SPECTRUM_FALL / SPECTRUM_FLOOR * 2.0f * dt;
+        if(peaks[i] < levels[i])
+            peaks[i] = levels[i];
+    }
+}
+
+static void waterfall_init(struct waterfall *waterfall)
+{
+    glCreateTextures(GL_TEXTURE_2D, 1, &waterfall->texture);
+    glTextureStorage2D(waterfall->texture, 1, GL_R32F, WATERFALL_ROWS, WATERFALL_DEPTH);
+    glTextureParameteri(waterfall->texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(waterfall->texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(waterfall->texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(waterfall->texture, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    waterfall->staging = safe_malloc(WATERFALL_ROWS * WATERFALL_DEPTH * sizeof(float));
+    waterfall->hop = 1024;
+    waterfall->last = SIZE_MAX;
+    waterfall->next = 0;
+}
+
+static void waterfall_shutdown(struct waterfall *waterfall)
+{
+    glDeleteTextures(1, &waterfall->texture);
+    free(waterfall->staging);
+    memset(waterfall, 0, sizeof(struct waterfall));
+}
+
+/* Appends a column for every hop the playhead went
+ * past since the last frame and uploads only those.
+ * After a seek, or when it fell behind by more than
+ * the whole ring, it starts over from the playhead. */
+static void waterfall_update(struct waterfall *waterfall, struct ubo_data *ubo, size_t position)
+{
+    size_t i, count, part;
+
+    if(waterfall->last == SIZE_MAX || position < waterfall->last || position - waterfall->last > waterfall->hop * WATERFALL_DEPTH) {
+        glClearTexImage(waterfall->texture, 0, GL_RED, GL_FLOAT, NULL);
+        waterfall->last = position;
+        waterfall->next = 0;
+    }
+
+    count = (position - waterfall->last) / waterfall->hop;
+    for(i = 0; i < count; i++) {
+        waterfall->last += waterfall->hop;
+        spectrum_analyze(&g_spectrum, waterfall->last);
+        spectrum_resample(&g_spectrum, waterfall->staging + i * WATERFALL_ROWS, WATERFALL_ROWS);
+    }
+
+    for(i = 0; i < count; i += part) {
+        part = count - i;
+        if(part > WATERFALL_DEPTH - waterfall->next)
+            part = WATERFALL_DEPTH - waterfall->next;
+        glTextureSubImage2D(waterfall->texture, 0, 0, (GLint)waterfall->next, WATERFALL_ROWS, (GLsizei)part, GL_RED, GL_FLOAT, waterfall->staging + i * WATERFALL_ROWS);
+        waterfall->next = (waterfall->next + part) % WATERFALL_DEPTH;
+    }
+
+    ubo->waterfall[0] = (float)waterfall->next / (float)WATERFALL_DEPTH;
+}
+
+static void wave_ring_init(struct wave_ring *ring, size_t size)
+{
+    GLint align = 1;
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &align);
+    if(align < 1)
+        align = 1;
+
+    ring->size = size;
+    ring->stride = (size + (size_t)align - 1) / (size_t)align * (size_t)align;
+    ring->segment = 0;
+    memset(ring->fences, 0, sizeof(ring->fences));
+
+    glCreateBuffers(1, &ring->buffer);
+    glNamedBufferStorage(ring->buffer, (GLsizeiptr)(ring->stride * WAVE_SEGMENTS), NULL, flags);
+    ring->map = glMapNamedBufferRange(ring->buffer, 0, (GLsizeiptr)(ring->stride * WAVE_SEGMENTS), flags);
+}
+
+static void wave_ring_shutdown(struct wave_ring *ring)
+{
+    size_t i;
+    for(i = 0; i < WAVE_SEGMENTS; i++)
+        glDeleteSync(ring->fences[i]);
+    glUnmapNamedBuffer(ring->buffer);
+    glDeleteBuffers(1, &ring->buffer);
+    memset(ring, 0, sizeof(struct wave_ring));
+}
+
+/* Moves on to the next segment and waits for the GPU
+ * to be done with the frame that last used it. */
+static float *wave_ring_acquire(struct wave_ring *ring)
+{
+    GLenum status;
+    GLsync *fence;
+
+    ring->segment = (ring->segment + 1) % WAVE_SEGMENTS;
+    fence = &ring->fences[ring->segment];
+    if(*fence) {
+        do {
+            status = glClientWaitSync(*fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        } while(status == GL_TIMEOUT_EXPIRED);
+        glDeleteSync(*fence);
+        *fence = NULL;
+    }
+
+    return (float *)((unsigned char *)ring->map + ring->segment * ring->stride);
+}
+
+/* Fences the segment after the last draw reading it. */
+static void wave_ring_release(struct wave_ring *ring)
+{
+    ring->fences[ring->segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+static void wave_ring_bind(struct wave_ring *ring, GLuint index)
+{
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, index, ring->buffer, (GLintptr)(ring->segment * ring->stride), (GLsizeiptr)ring->size);
+}
+
+/* Dimensions are rounded down to even for the 4:2:0
+ * chroma. Leaves the framebuffer bound for drawing. */
+static int video_init(struct video_out *video, const char *path, size_t width, size_t height, size_t fps)
+{
+    size_t frame_size;
+
+    video->width = width & ~(size_t)1;
+    video->height = height & ~(size_t)1;
+    video->frames = 0;
+    if(!video->width || !video->height)
+        return 0;
+
+    video->file = strcmp(path, "-") ? fopen(path, "wb") : stdout;
+    if(!video->file)
+        return 0;
+
+    frame_size = video->width * video->height * 4;
+    video->yuv = safe_malloc(video->width * video->height * 3 / 2);
+
+    glCreateRenderbuffers(1, &video->color);
+    glNamedRenderbufferStorage(video->color, GL_RGBA8, (GLsizei)video->width, (GLsizei)video->height);
+    glCreateFramebuffers(1, &video->framebuffer);
+    glNamedFramebufferRenderbuffer(video->framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, video->color);
+    glBindFramebuffer(GL_FRAMEBUFFER, video->framebuffer);
+
+    glCreateBuffers(2, video->pixels);
+    glNamedBufferStorage(video->pixels[0], (GLsizeiptr)frame_size, NULL, GL_MAP_READ_BIT | GL_CLIENT_STORAGE_BIT);
+    glNamedBufferStorage(video->pixels[1], (GLsizeiptr)frame_size, NULL, GL_MAP_READ_BIT | GL_CLIENT_STORAGE_BIT);
+
+    fprintf(video->file, "YUV4MPEG2 W%zu H%zu F%zu:1 Ip A1:1 C420jpeg\n", video->width, video->height, fps);
+    return 1;
+}
+
+/* Full range BT.601, rows flipped from the bottom-up
+ * order OpenGL reads them in. */
+static void video_write(struct video_out *video, GLuint buffer)
+{
+    size_t x, y, i;
+    const unsigned char *p, *row;
+    unsigned char *luma = video->yuv;
+    unsigned char *cb = luma + video->width * video->height;
+    unsigned char *cr = cb + video->width * video->height / 4;
+    size_t stride = video->width * 4;
+    const unsigned char *rgba = glMapNamedBuffer(buffer, GL_READ_ONLY);
+
+    if(!rgba)
+        return;
+
+    for(y = 0; y < video->height; y++) {
+        row = rgba + (video->height - 1 - y) * stride;
+        for(x = 0; x < video->width; x++) {
+            p = row + x * 4;
+            *luma++ = (unsigned char)((77 * p[0] + 150 * p[1] + 29 * p[2] + 128) >> 8);
+        }
+    }
+
+    for(y = 0; y < video->height; y += 2) {
+        row = rgba + (video->height - 2 - y) * stride;
+        for(x = 0; x < video->width; x += 2) {
+            int r = 0, g = 0, b = 0;
+            for(i = 0; i < 4; i++) {
+                p = row + (i >> 1) * stride + (x + (i & 1)) * 4;
+                r += p[0];
+                g += p[1];
+                b += p[2];
+            }
+
+            *cb++ = (unsigned char)(128 + ((-43 * r - 85 * g + 128 * b + 512) >> 10));
+            *cr++ = (unsigned char)(128 + ((128 * r - 107 * g - 21 * b + 512) >> 10));
+        }
+    }
+
+    glUnmapNamedBuffer(buffer);
+    fputs("FRAME\n", video->file);
+    fwrite(video->yuv, 1, video->width * video->height * 3 / 2, video->file);
+}
+
+/* Starts reading back the frame just drawn and
+ * writes out the one before it. */
+static void video_capture(struct video_out *video)
+{
+    GLuint buffer = video->pixels[video->frames % 2];
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+    glReadPixels(0, 0, (GLsizei)video->width, (GLsizei)video->height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if(video->frames)
+        video_write(video, video->pixels[(video->frames - 1) % 2]);
+    video->frames++;
+}
+
+static void video_finish(struct video_out *video)
+{
+    if(video->frames)
+        video_write(video, video->pixels[(video->frames - 1) % 2]);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &video->framebuffer);
+    glDeleteRenderbuffers(1, &video->color);
+    glDeleteBuffers(2, video->pixels);
+    if(video->file != stdout)
+        fclose(video->file);
+    else
+        fflush(stdout);
+    free(video->yuv);
+}
+
+static int audio_thread(void *arg)
+{
+    int done;
+    size_t head, tail, count, written;
+    struct audio_out *audio = arg;
+    const struct timespec nap = { 0, 2000000 };
+
+    tail = atomic_load_explicit(&audio->tail, memory_order_relaxed);
+    for(;;) {
+        done = atomic_load_explicit(&audio->done, memory_order_acquire);
+        head = atomic_load_explicit(&audio->head, memory_order_acquire);
+        if(head == tail) {
+            if(done)
+                break;
+            thrd_sleep(&nap, NULL);
+            continue;
+        }
+
+        /* Up to the end of the ring at most. */
+        count = head - tail;
+        if(count > audio->mask + 1 - (tail & audio->mask))
+            count = audio->mask + 1 - (tail & audio->mask);
+        written = (size_t)drwav_write_pcm_frames(&audio->wav, count, audio->frames + (tail & audio->mask) * audio->channels);
+        if(written != count) {
+            lprintf("render: wrote only %zu of %zu audio frames", written, count);
+            atomic_store_explicit(&audio->failed, 1, memory_order_release);
+            return 0;
+        }
+        tail += count;
+        atomic_store_explicit(&audio->tail, tail, memory_order_release);
+    }
+
+    return 0;
+}
+
+/* 32-bit float, so the file holds exactly what the
+ * callback would have handed to PortAudio. */
+static int audio_init(struct audio_out *audio, const char *path, const struct pa_state *state)
+{
+    drwav_data_format format;
+
+    format.container = drwav_container_riff;
+    format.format = DR_WAVE_FORMAT_IEEE_FLOAT;
+    format.channels = (drwav_uint32)state->num_channels;
+    format.sampleRate = (drwav_uint32)state->sample_rate;
+    format.bitsPerSample = 32;
+    if(!drwav_init_file_write(&audio->wav, path, &format, NULL))
+        return 0;
+
+    audio->frames = safe_malloc(AUDIO_OUT_FRAMES * state->num_channels * sizeof(float));
+    audio->mask = AUDIO_OUT_FRAMES - 1;
+    audio->channels = state->num_channels;
+    audio->position = 0;
+    atomic_init(&audio->head, 0);
+    atomic_init(&audio->tail, 0);
+    atomic_init(&audio->done, 0);
+    atomic_init(&audio->failed, 0);
+
+    if(thrd_create(&audio->thread, &audio_thread, audio) != thrd_success) {
+        drwav_uninit(&audio->wav);
+        free(audio->frames);
+        return 0;
+    }
+
+    return 1;
+}
+
+/* Queues the output up to frame `last`, silence past
+ * the end of the track as in the callback. Waits for
+ * the writer when the ring is full, unless it has
+ * stopped on a write error. */
+static void audio_queue(struct audio_out *audio, const struct pa_state *state, size_t last)
+{
+    size_t tail;
+    float *out;
+    const struct timespec nap = { 0, 1000000 };
+
+    while(audio->position < last) {
+        if(atomic_load_explicit(&audio->failed, memory_order_acquire))
+            return;
+        tail = atomic_load_explicit(&audio->tail, memory_order_acquire);
+        if(audio->position - tail > audio->mask) {
+            thrd_sleep(&nap, NULL);
+            continue;
+        }
+
+        out = audio->frames + (audio->position & audio->mask) * audio->channels;
+        if(audio->position < state->num_samples)
+            output_frame(state, audio->position, out);
+        else
+            memset(out, 0, audio->channels * sizeof(float));
+        atomic_store_explicit(&audio->head, ++audio->position, memory_order_release);
+    }
+}
+
+/* Returns 0 if the writer gave up on the file. */
+static int audio_finish(struct audio_out *audio)
+{
+    atomic_store_explicit(&audio->done, 1, memory_order_release);
+    thrd_join(audio->thread, NULL);
+    drwav_uninit(&audio->wav);
+    free(audio->frames);
+    return !atomic_load_explicit(&audio->failed, memory_order_acquire);
+}
+
+static void profile_init(struct profile *profile, double period)
+{
+    memset(profile, 0, sizeof(struct profile));
+    glCreateQueries(GL_TIME_ELAPSED, PROFILE_QUERIES, profile->queries);
+    profile->period = period;
+    profile->start = profile->mark = glfwGetTime();
+}
+
+static void profile_shutdown(struct profile *profile)
+{
+    glDeleteQueries(PROFILE_QUERIES, profile->queries);
+}
+
+static void profile_add(struct profile *profile, enum profile_timing timing, double seconds)
+{
+    profile->history[timing][profile->counts[timing]++ % PROFILE_FRAMES] = (float)(seconds * 1000.0);
+}
+
+static void profile_mark(struct profile *profile, enum profile_timing timing)
+{
+    double t = glfwGetTime();
+    profile->phases[timing] += t - profile->mark;
+    profile->mark = t;
+}
+
+/* Closes the last frame, picks up the queries that
+ * have finished since and starts timing this one. */
+static void profile_frame(struct profile *profile)
+{
+    GLint available;
+    GLuint64 elapsed;
+    GLuint query;
+    double frame;
+    int i;
+
+    profile_mark(profile, TIMING_OTHER);
+    if(profile->frames) {
+        frame = profile->mark - profile->start;
+        profile_add(profile, TIMING_FRAME, frame);
+        for(i = TIMING_FILL; i < NUM_TIMINGS; i++)
+            profile_add(profile, i, profile->phases[i]);
+
+        /* Half a period late means a missed swap. */
+        if(profile->period > 0.0 && frame > profile->period * 1.5)
+            profile->dropped += (size_t)(frame / profile->period - 0.5);
+    }
+
+    memset(profile->phases, 0, sizeof(profile->phases));
+    profile->start = profile->mark;
+    profile->frames++;
+
+    while(profile->collected < profile->issued) {
+        query = profile->queries[profile->collected % PROFILE_QUERIES];
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if(!available)
+            break;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+        profile_add(profile, TIMING_GPU, (double)elapsed * 1e-9);
+        profile->collected++;
+    }
+
+    profile->querying = profile->issued - profile->collected < PROFILE_QUERIES;
+    if(profile->querying)
+        glBeginQuery(GL_TIME_ELAPSED, profile->queries[profile->issued % PROFILE_QUERIES]);
+}
+
+static void profile_end(struct profile *profile)
+{
+    if(profile->querying) {
+        glEndQuery(GL_TIME_ELAPSED);
+        profile->issued++;
+        profile->querying = 0;
+    }
+}
+
+static int compare_floats(const void *a, const void *b)
+{
+    float x = *(const float *)a;
+    float y = *(const float *)b;
+    return (x > y) - (x < y);
+}
 
-static void lvprintf(const char *fmt, va_list va)
+/* Minimum, mean and 99th percentile of the frames
+ * kept, zero when nothing was measured yet. */
+static int profile_stats(const struct profile *profile, enum profile_timing timing, float *out)
 {
-    vsnprintf(g_logbuf, sizeof(g_logbuf), fmt, va);
-    fprintf(stderr, "%s\r\n", g_logbuf);
+    float sorted[PROFILE_FRAMES];
+    double sum = 0.0;
+    size_t i, n;
+
+    n = profile->counts[timing] < PROFILE_FRAMES ? profile->counts[timing] : PROFILE_FRAMES;
+    if(!n)
+        return 0;
+
+    memcpy(sorted, profile->history[timing], n * sizeof(float));
+    qsort(sorted, n, sizeof(float), &compare_floats);
+    for(i = 0; i < n; i++)
+        sum += sorted[i];
+
+    out[0] = sorted[0];
+    out[1] = (float)(sum / (double)n);
+    out[2] = sorted[(n - 1) * 99 / 100];
+    return 1;
 }
 
-static void lprintf(const char *fmt, ...)
+/* Fills a row of the grid with glyph indices; the
+ * font has no lower case and nothing past Z. */
+static void hud_print(struct profile *profile, size_t row, const char *fmt, ...)
 {
+    char line[HUD_COLUMNS + 1];
+    size_t i, length;
     va_list va;
+    int c;
+
     va_start(va, fmt);
-    lvprintf(fmt, va);
+    vsnprintf(line, sizeof(line), fmt, va);
     va_end(va);
+
+    length = strlen(line);
+    for(i = 0; i < HUD_COLUMNS; i++) {
+        c = i < length ? line[i] : ' ';
+        if(c >= 'a' && c <= 'z')
+            c -= 'a' - 'A';
+        if(c < ' ' || c > 'Z')
+            c = '?';
+        profile->text[row * HUD_COLUMNS + i] = (GLuint)(c - ' ');
+    }
 }
 
-static void *safe_malloc(size_t n)
+static void hud_update(struct profile *profile, const struct callback_stats *stats, GLuint buffer)
 {
-    void *block = malloc(n);
-    if(!block) {
-        lprintf("out of memory!");
-        abort();
+    static const char *names[NUM_TIMINGS] = { "frame", "gpu", "fill", "upload", "swap", "other" };
+    static const char *modes[NUM_TRIGGER_MODES] = { "off", "auto", "normal", "single" };
+    static const char *windows[NUM_WINDOWS] = { "hann", "blackman" };
+    float times[3];
+    int i;
+
+    hud_print(profile, 0, "%-7s%8s%8s%8s", "ms", "min", "avg", "p99");
+    for(i = 0; i < NUM_TIMINGS; i++) {
+        if(profile_stats(profile, i, times))
+            hud_print(profile, (size_t)i + 1, "%-7s%8.2f%8.2f%8.2f", names[i], times[0], times[1], times[2]);
+        else
+            hud_print(profile, (size_t)i + 1, "%-7s%8s%8s%8s", names[i], "-", "-", "-");
     }
 
-    return block;
+    hud_print(profile, NUM_TIMINGS + 1, "dropped %zu of %zu", profile->dropped, profile->frames);
+
+    /* The audio callback, if there is a stream. */
+    if(atomic_load_explicit(&stats->calls, memory_order_relaxed)) {
+        hud_print(profile, NUM_TIMINGS + 2, "audio  p99 <%.3f max %.3f", callback_percentile(stats, 0.99) * 1e-6,
+            (double)atomic_load_explicit(&stats->longest, memory_order_relaxed) * 1e-6);
+        hud_print(profile, NUM_TIMINGS + 3, "budget %.3f late %zu", (double)atomic_load_explicit(&stats->budget, memory_order_relaxed) * 1e-6,
+            atomic_load_explicit(&stats->late, memory_order_relaxed));
+        hud_print(profile, NUM_TIMINGS + 4, "xruns %zu starved %zu", atomic_load_explicit(&stats->underflows, memory_order_relaxed) + atomic_load_explicit(&stats->overflows, memory_order_relaxed),
+            atomic_load_explicit(&stats->starved, memory_order_relaxed));
+    } else {
+        hud_print(profile, NUM_TIMINGS + 2, "audio  -");
+        hud_print(profile, NUM_TIMINGS + 3, "");
+        hud_print(profile, NUM_TIMINGS + 4, "");
+    }
+
+    hud_print(profile, NUM_TIMINGS + 5, "trig %s %s %+.2f%s", modes[g_trigger.mode], g_trigger.falling ? "fall" : "rise", g_trigger.level,
+        g_trigger.mode == TRIGGER_SINGLE && g_trigger.armed ? " armed" : "");
+    hud_print(profile, NUM_TIMINGS + 6, "hyst %.2f hold %.1f ms", g_trigger.hysteresis, (double)g_trigger.holdoff * 1000.0 / (double)g_state.sample_rate);
+    hud_print(profile, NUM_TIMINGS + 7, "fft %zu %s hop %zu %s", (size_t)1 << g_spectrum.bits, windows[g_spectrum.window], g_waterfall.hop,
+        g_gpu_fft ? "gpu" : "cpu");
+
+    glNamedBufferSubData(buffer, 0, sizeof(profile->text), profile->text);
 }
 
-static void on_error(int code, const char *message)
+/* On top of everything at an integer scale. */
+static void hud_draw(int width, int height)
 {
-    lprintf("glfw: %s", message);
+    glViewport(0, 0, width, height);
+    glUseProgram(g_hud_program);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, g_bufs[BUF_HUD]);
+    glProgramUniform4f(g_hud_program, 0, (float)width, (float)height, (float)(1 + height / 960), (float)HUD_COLUMNS);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, HUD_COLUMNS * HUD_ROWS);
 }
 
-static GLuint make_shader(GLenum stage, const char *source)
+/* A single white lane for the mix, otherwise one
+ * hue per channel spread around the color wheel. */
+static void set_lanes(struct ubo_data *ubo, size_t lanes)
 {
-    char *info_log;
-    GLint status, length;
-    GLuint shader;
+    size_t j;
+    float hue;
+
+    ubo->lanes[0] = (GLuint)lanes;
+    for(j = 0; j < lanes; j++) {
+        hue = (float)j / (float)lanes * 2.0f * (float)M_PI;
+        ubo->lane_color[j][0] = lanes > 1 ? 0.6f + 0.4f * cosf(hue) : 1.0f;
+        ubo->lane_color[j][1] = lanes > 1 ? 0.6f + 0.4f * cosf(hue - 2.0f * (float)M_PI / 3.0f) : 1.0f;
+        ubo->lane_color[j][2] = lanes > 1 ? 0.6f + 0.4f * cosf(hue + 2.0f * (float)M_PI / 3.0f) : 1.0f;
+        ubo->lane_color[j][3] = 1.0f - (float)(j * 2 + 1) / (float)lanes;
+    }
+}
 
-    shader = glCreateShader(stage);
-    glShaderSource(shader, 1, &source, NULL);
-    glCompileShader(shader);
+/* Makes the first `count` frames of `chunk` resident,
+ * uploading only the ones that are not there yet. */
+static void upload_chunk(struct gpu_track *track, size_t chunk, size_t count)
+{
+    size_t slot = chunk & 1;
+    size_t first = chunk * track->chunk;
+    size_t frame_size = frame_bytes(&g_state);
+
+    if(first >= g_state.num_samples)
+        return;
+    if(count > track->chunk)
+        count = track->chunk;
+    if(count > g_state.num_samples - first)
+        count = g_state.num_samples - first;
+    if(track->resident[slot] != chunk) {
+        track->resident[slot] = chunk;
+        track->filled[slot] = 0;
+    }
+    if(track->filled[slot] >= count)
+        return;
 
-    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
-    if(length > 1) {
-        info_log = safe_malloc((size_t)length + 1);
-        glGetShaderInfoLog(shader, length, NULL, info_log);
-        lprintf("%s", info_log);
-        free(info_log);
+    first += track->filled[slot];
+    count -= track->filled[slot];
+    if(g_state.map)
+        map_convert(&g_state, first, first + count);
+
+    glNamedBufferSubData(track->buffer, (GLintptr)((slot * track->chunk + track->filled[slot]) * frame_size), (GLsizeiptr)(count * frame_size), frame_at(&g_state, first));
+    track->filled[slot] += count;
+}
+
+static int gpu_track_init(struct gpu_track *track, size_t window)
+{
+    GLint64 max_size;
+    size_t frame_size = frame_bytes(&g_state);
+
+    glGetInteger64v(GL_MAX_SHADER_STORAGE_BLOCK_SIZE, &max_size);
+    glCreateBuffers(1, &track->buffer);
+
+    /* The common case: everything fits, upload it once.
+     * Compact samples are padded to a whole word. */
+    if(g_state.num_samples * frame_size <= (size_t)max_size) {
+        if(g_state.map)
+            map_convert(&g_state, 0, g_state.num_samples);
+        track->chunk = g_state.num_samples;
+        glNamedBufferStorage(track->buffer, (GLsizeiptr)((g_state.num_samples * frame_size + 3) & ~(size_t)3), g_state.samples, 0);
+        return 1;
     }
 
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
-    if(!status) {
-        glDeleteShader(shader);
+    /* Otherwise the window has to fit in a chunk so
+     * that it never spans more than two of them. An
+     * even chunk keeps 16-bit samples in whole words. */
+    track->chunk = (size_t)max_size / 2 / frame_size & ~(size_t)1;
+    if(track->chunk < window) {
+        glDeleteBuffers(1, &track->buffer);
         return 0;
     }
 
-    return shader;
+    glNamedBufferStorage(track->buffer, (GLsizeiptr)(track->chunk * 2 * frame_size), NULL, GL_DYNAMIC_STORAGE_BIT);
+    track->resident[0] = track->resident[1] = SIZE_MAX;
+    track->filled[0] = track->filled[1] = 0;
+    return 1;
 }
 
-static GLuint make_program(GLuint vert, GLuint frag)
+/* Fills the track part of the UBO for the window
+ * ending at the playhead and, when the track is
+ * chunked, streams in the chunk after the one the
+ * window starts in a slice per frame, ahead of the
+ * window reaching it. Only a seek or a window that
+ * catches up with the slices uploads more at once. */
+static size_t gpu_track_update(struct gpu_track *track, struct ubo_data *ubo, size_t position)
 {
-    char *info_log;
-    GLint status, length;
-    GLuint program;
-
-    program = glCreateProgram();
-    glAttachShader(program, vert);
-    glAttachShader(program, frag);
-    glLinkProgram(program);
+    size_t chunk, start, next, ahead, slice;
+    int64_t first;
+    size_t num_samples = g_state.num_samples - position;
+    if(num_samples > g_view_frames)
+        num_samples = g_view_frames;
+
+    first = (int64_t)position - (int64_t)num_samples;
+    start = first > 0 ? (size_t)first : 0;
+
+    if(track->chunk < g_state.num_samples) {
+        chunk = start / track->chunk;
+        upload_chunk(track, chunk, track->chunk);
+
+        next = (chunk + 1) * track->chunk;
+        ahead = track->resident[(chunk + 1) & 1] == chunk + 1 ? track->filled[(chunk + 1) & 1] : 0;
+        slice = TRACK_SLICE / frame_bytes(&g_state);
+        if(position > next && position - next > ahead + slice)
+            slice = position - next - ahead;
+        upload_chunk(track, chunk + 1, ahead + slice);
+    }
 
-    /* get rid of these */
-    glDeleteShader(vert);
-    glDeleteShader(frag);
+    ubo->track[0] = (GLuint)(start % (track->chunk < g_state.num_samples ? track->chunk * 2 : g_state.num_samples));
+    ubo->track[1] = (GLuint)(start - first);
+    ubo->track[2] = (GLuint)num_samples;
+    ubo->track[3] = (GLuint)g_state.num_channels;
+    return num_samples;
+}
 
-    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
-    if(length > 1) {
-        info_log = safe_malloc((size_t)length + 1);
-        glGetProgramInfoLog(program, length, NULL, info_log);
-        lprintf("%s", info_log);
-        free(info_log);
+/* Copies frames [first, last) into `buffer` as they
+ * are, only split where the decode ring wraps around. */
+static void upload_frames(GLuint buffer, size_t first, size_t last)
+{
+    size_t part, offset = 0;
+    size_t frame_size = frame_bytes(&g_state);
+
+    while(first < last) {
+        part = last - first;
+        if(g_state.ring && part > g_state.ring->mask + 1 - (first & g_state.ring->mask))
+            part = g_state.ring->mask + 1 - (first & g_state.ring->mask);
+        glNamedBufferSubData(buffer, (GLintptr)(offset * frame_size), (GLsizeiptr)(part * frame_size), frame_at(&g_state, first));
+        offset += part;
+        first += part;
     }
+}
 
-    glGetProgramiv(program, GL_LINK_STATUS, &status);
-    if(!status) {
-        glDeleteProgram(program);
-        return 0;
-    }
+/* XY and phosphor modes use the frames themselves,
+ * the track part of the UBO describes them the same
+ * way as for the GPU mode. */
+static size_t fill_frames(struct ubo_data *ubo, size_t position)
+{
+    size_t first;
+    size_t count = g_wave_ring.size / frame_bytes(&g_state);
+    if(count > g_view_frames)
+        count = g_view_frames;
+
+    first = position > count ? position - count : 0;
+    if(first < frames_base(&g_state))
+        first = frames_base(&g_state);
+
+    ubo->track[0] = 0;
+    ubo->track[1] = (GLuint)(count - (position - first));
+    ubo->track[2] = (GLuint)count;
+    ubo->track[3] = (GLuint)g_state.num_channels;
+    copy_frames(g_wave_table, first, position);
+    return count;
+}
 
-    return program;
+/* A line strip of count vertices per instance as
+ * LINE_SRC quads, six vertices for each segment. */
+static void draw_lines(size_t first, size_t count, size_t instances)
+{
+    if(count < 2)
+        return;
+    glDrawArraysInstanced(GL_TRIANGLES, (GLint)(first * 6), (GLsizei)((count - 1) * 6), (GLsizei)instances);
 }
 
-static int pa_callback(const void *input, void *output, unsigned long framerate, const PaStreamCallbackTimeInfo *time_info, PaStreamCallbackFlags flags, void *arg)
+static void fft_dispatch(GLuint step, GLuint n, GLuint s, GLuint source, size_t invocations)
 {
-    size_t j;
-    unsigned long i;
-    float *fl_output = output;
-    struct pa_state *state = arg;
-    for(i = 0; i < framerate; i++) {
-        if(state->position >= state->num_samples)
-            return paComplete;
-        for(j = 0; j < state->num_channels; j++)
-            *fl_output++ = state->samples[state->position * state->num_channels + j] * 0.25f;
-        state->position++;
+    glProgramUniform4ui(g_fft_program, 0, step, n, s, source);
+    glDispatchCompute((GLuint)((invocations + FFT_GROUP - 1) / FFT_GROUP), 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+/* spectrum_update on the GPU, leaving the levels and
+ * the peak hold in the spectrum SSBO for the draw.
+ * With the whole track resident the frames are read
+ * right from it, otherwise just the ones needed are
+ * uploaded; nothing is ever read back. */
+static void gpu_spectrum_update(struct spectrum *spec, size_t position, size_t num_columns, float dt)
+{
+    GLuint source = 0;
+    size_t m, n = (size_t)1 << spec->bits;
+    size_t start = position > n ? position - n : 0;
+
+    if(num_columns > spec->max_columns)
+        num_columns = spec->max_columns;
+    if(num_columns != spec->num_columns)
+        spec->stale = 1;
+    spec->num_columns = num_columns;
+    if(num_columns < 2)
+        return;
+
+    if(g_track.buffer && g_track.chunk >= g_state.num_samples) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, g_track.buffer);
+        glProgramUniform4i(g_fft_program, 2, (GLint)((int64_t)position - (int64_t)n), (GLint)g_state.num_samples, (GLint)g_state.format, 0);
+    } else {
+        if(start < frames_base(&g_state))
+            start = frames_base(&g_state);
+        upload_frames(g_bufs[BUF_FFTI], start, position);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, g_bufs[BUF_FFTI]);
+        glProgramUniform4i(g_fft_program, 2, (GLint)((int64_t)position - (int64_t)n - (int64_t)start), (GLint)(position - start), (GLint)g_state.format, 0);
+    }
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, g_bufs[BUF_FFTW]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, g_bufs[BUF_FFTB]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, g_bufs[BUF_SPEC]);
+
+    m = n / 2;
+    glUseProgram(g_fft_program);
+    glProgramUniform4ui(g_fft_program, 1, (GLuint)m, (GLuint)spec->window, (GLuint)g_state.num_channels, (GLuint)num_columns);
+    glProgramUniform4f(g_fft_program, 3, (float)g_state.sample_rate, SPECTRUM_FALL / SPECTRUM_FLOOR * 2.0f * dt, spec->stale ? 1.0f : 0.0f, 0.0f);
+    spec->stale = 0;
+
+    fft_dispatch(0, 0, 0, 0, m);
+    for(n = m; n >= 4; n /= 4) {
+        fft_dispatch(1, (GLuint)n, (GLuint)(m / n), source, m / 4);
+        source = !source;
+    }
+
+    if(n == 2) {
+        fft_dispatch(2, 2, (GLuint)(m / 2), source, m / 2);
+        source = !source;
     }
 
-    return paContinue;
+    fft_dispatch(3, 0, 0, source, m + 1);
+    fft_dispatch(4, 0, 0, 0, num_columns);
 }
 
-static void fill_signal_tab(int scr_width)
+static void on_key(GLFWwindow *window, int key, int scancode, int action, int mods)
 {
-    int i;
-    size_t j, off;
-    int64_t scratch = (int64_t)g_state.position - (int64_t)g_state.num_samples;
-    size_t num_samples = g_state.num_samples - g_state.position;
-    if(num_samples > g_wave_table_size)
-        num_samples = g_wave_table_size;
-    for(i = 0; i < num_samples; i++) {
-        g_wave_table[i][0] = (float)i / (float)num_samples * 2.0f - 1.0f;
-        g_wave_table[i][1] = 0.0f;
-        off = g_state.position + i;
-        if(off >= num_samples) {
-            for(j = 0; j < g_state.num_channels; j++)
-                g_wave_table[i][1] += g_state.samples[(off - num_samples) * g_state.num_channels + j];
-            g_wave_table[i][1] /= (float)g_state.num_channels;
+    size_t limit, position;
+
+    if(action == GLFW_PRESS && key == GLFW_KEY_SPACE) {
+        if(!Pa_IsStreamActive(g_stream))
+            Pa_StartStream(g_stream);
+        else
+            atomic_store_explicit(&g_state.paused, !atomic_load_explicit(&g_state.paused, memory_order_relaxed), memory_order_release);
+    }
+
+    /* Seeks only ask, the callback picks the new
+     * position up at the start of its next buffer. */
+    if(action != GLFW_RELEASE && (key == GLFW_KEY_LEFT || key == GLFW_KEY_RIGHT)) {
+        position = read_playhead(&g_state).position;
+        if(key == GLFW_KEY_RIGHT)
+            request_seek(&g_state, position + g_state.sample_rate);
+        else
+            request_seek(&g_state, position > g_state.sample_rate ? position - g_state.sample_rate : 0);
+    }
+
+    if(action == GLFW_PRESS && key == GLFW_KEY_HOME)
+        request_seek(&g_state, 0);
+
+    if(action == GLFW_PRESS && key == GLFW_KEY_L)
+        atomic_store_explicit(&g_state.loop, !atomic_load_explicit(&g_state.loop, memory_order_relaxed), memory_order_relaxed);
+
+    /* Zooming out past the initial window needs the
+     * pyramid, the raw paths would go through every
+     * sample and a chunked GPU track may not hold it. */
+    if(action != GLFW_RELEASE && key == GLFW_KEY_UP) {
+        limit = g_window_frames;
+        if(!g_track.buffer && atomic_load_explicit(&g_pyramid.ready, memory_order_acquire))
+            limit = g_state.num_samples;
+        if(g_view_frames * 2 <= limit)
+            g_view_frames *= 2;
+    }
+
+    if(action != GLFW_RELEASE && key == GLFW_KEY_DOWN && g_view_frames / 2 >= PYRAMID_BASE)
+        g_view_frames /= 2;
+
+    if(action == GLFW_PRESS && key == GLFW_KEY_T) {
+        g_trigger.mode = (g_trigger.mode + 1) % NUM_TRIGGER_MODES;
+        g_trigger.armed = 1;
+    }
+
+    if(action == GLFW_PRESS && key == GLFW_KEY_E)
+        g_trigger.falling = !g_trigger.falling;
+
+    if(action == GLFW_PRESS && key == GLFW_KEY_R)
+        g_trigger.armed = 1;
+
+    /* Brackets move the level, with shift the hysteresis. */
+    if(action != GLFW_RELEASE && (key == GLFW_KEY_LEFT_BRACKET || key == GLFW_KEY_RIGHT_BRACKET)) {
+        if(mods & GLFW_MOD_SHIFT) {
+            g_trigger.hysteresis += key == GLFW_KEY_RIGHT_BRACKET ? 0.01f : -0.01f;
+            if(g_trigger.hysteresis < 0.0f)
+                g_trigger.hysteresis = 0.0f;
+        } else {
+            g_trigger.level += key == GLFW_KEY_RIGHT_BRACKET ? 0.05f : -0.05f;
+        }
+    }
+
+    if(action == GLFW_PRESS && key == GLFW_KEY_P) {
+        g_phosphor = !g_phosphor;
+        if(g_phosphor)
+            glClearTexImage(g_phosphor_image, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+    }
+
+    if(action == GLFW_PRESS && key == GLFW_KEY_X) {
+        if(g_state.num_channels < 2)
+            lprintf("xy mode needs at least two channels");
+        else
+            g_xy = !g_xy;
+    }
+
+    if(action == GLFW_PRESS && key == GLFW_KEY_F) {
+        g_spectrum_view = (g_spectrum_view + 1) % NUM_SPECTRUM_VIEWS;
+        g_spectrum.stale = 1;
+        g_waterfall.last = SIZE_MAX;
+    }
+
+    if(action == GLFW_PRESS && key == GLFW_KEY_G) {
+        g_gpu_fft = !g_gpu_fft;
+        g_spectrum.stale = 1;
+    }
+
+    if(action == GLFW_PRESS && key == GLFW_KEY_W) {
+        g_spectrum.window = (g_spectrum.window + 1) % NUM_WINDOWS;
+        g_spectrum.stale = 1;
+    }
+
+    /* Page up/down change the size, with shift the
+     * hop between the columns of the spectrogram. */
+    if(action == GLFW_PRESS && (key == GLFW_KEY_PAGE_UP || key == GLFW_KEY_PAGE_DOWN)) {
+        if(mods & GLFW_MOD_SHIFT) {
+            if(key == GLFW_KEY_PAGE_UP && g_waterfall.hop < ((size_t)1 << FFT_MAX_BITS))
+                g_waterfall.hop *= 2;
+            if(key == GLFW_KEY_PAGE_DOWN && g_waterfall.hop > MIN_HOP)
+                g_waterfall.hop /= 2;
+            g_waterfall.last = SIZE_MAX;
+        } else {
+            if(key == GLFW_KEY_PAGE_UP && g_spectrum.bits < FFT_MAX_BITS)
+                g_spectrum.bits++;
+            if(key == GLFW_KEY_PAGE_DOWN && g_spectrum.bits > FFT_MIN_BITS)
+                g_spectrum.bits--;
+            g_spectrum.stale = 1;
         }
     }
+
+    /* Minus and equals make the lines thinner or thicker. */
+    if(action != GLFW_RELEASE && (key == GLFW_KEY_MINUS || key == GLFW_KEY_EQUAL)) {
+        if(key == GLFW_KEY_MINUS && g_line_width > 1.0f)
+            g_line_width -= 0.5f;
+        if(key == GLFW_KEY_EQUAL && g_line_width < 16.0f)
+            g_line_width += 0.5f;
+    }
+
+    /* Switches between the mix and a lane per channel. */
+    if(action == GLFW_PRESS && key == GLFW_KEY_C) {
+        g_lanes = g_lanes > 1 ? 1 : g_state.num_channels < MAX_LANES ? g_state.num_channels : MAX_LANES;
+    }
+
+    /* Cycles the holdoff through 0, 1, 10 and 100 ms. */
+    if(action == GLFW_PRESS && key == GLFW_KEY_H) {
+        if(!g_trigger.holdoff)
+            g_trigger.holdoff = g_state.sample_rate / 1000;
+        else if(g_trigger.holdoff < g_state.sample_rate / 10)
+            g_trigger.holdoff *= 10;
+        else
+            g_trigger.holdoff = 0;
+    }
+
+    /* Frame timings over the top left corner. */
+    if(action == GLFW_PRESS && key == GLFW_KEY_I) {
+        g_profile.shown = !g_profile.shown;
+        g_profile.refresh = 0.0;
+    }
 }
 
-static void on_key(GLFWwindow *window, int key, int scancode, int action, int mods)
+static void context_hints(void)
 {
-    if(action == GLFW_PRESS && key == GLFW_KEY_SPACE && !Pa_IsStreamActive(g_stream))
-        Pa_StartStream(g_stream);
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_API);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+}
+
+/* A context nobody sees, for rendering to a file.
+ * Without a display server GLFW's null platform can
+ * still get one from surfaceless EGL (llvmpipe will
+ * do), otherwise it's a hidden window. */
+static GLFWwindow *open_offscreen(int width, int height)
+{
+#ifdef GLFW_PLATFORM_NULL
+    GLFWwindow *window;
+
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    if(glfwInit()) {
+        context_hints();
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+        if((window = glfwCreateWindow(width, height, "scope", NULL, NULL)))
+            return window;
+        glfwTerminate();
+    }
+
+    glfwInitHint(GLFW_PLATFORM, GLFW_ANY_PLATFORM);
+#endif
+
+    if(!glfwInit())
+        return NULL;
+
+    context_hints();
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    return glfwCreateWindow(width, height, "scope", NULL, NULL);
 }
 
 int main(int argc, char **argv)
@@ -208,12 +2242,24 @@ int main(int argc, char **argv)
     PaStreamParameters pa_params;
     GLFWmonitor *monitor;
     const GLFWvidmode *vidmode;
-    int width, height;
-    double t, pt, dt;
+    int width, height, trace_height;
+    double t, pt, dt, frame_period;
     GLuint vert, frag;
     struct ubo_data ubo;
+    struct playhead playhead;
+    struct video_out video;
+    struct audio_out audio;
     size_t width_mod = 1;
-
+    const char *path = NULL;
+    const char *render_path = NULL;
+    const char *audio_path = NULL;
+    size_t render_fps = 60;
+    int exit_code = 0;
+    int screen_width = 1280, screen_height = 720;
+    size_t count, position, history;
+    int i, streaming = 0, mapped = 0, resident = 0, compact = 0, hud = 0;
+
+    memset(&ubo, 0, sizeof(ubo));
     ubo.xyz_color[0] = 1.0f;
     ubo.xyz_color[1] = 1.0f;
     ubo.xyz_color[2] = 1.0f;
@@ -221,72 +2267,206 @@ int main(int argc, char **argv)
     if((pa_err = Pa_Initialize()) != paNoError)
         goto on_pa_error;
 
-    if(argc < 2) {
+    for(i = 1; i < argc; i++) {
+        if(!strcmp(argv[i], "--stream")) {
+            streaming = 1;
+            continue;
+        }
+
+        if(!strcmp(argv[i], "--mmap")) {
+            mapped = 1;
+            continue;
+        }
+
+        if(!strcmp(argv[i], "--gpu")) {
+            resident = 1;
+            continue;
+        }
+
+        if(!strcmp(argv[i], "--compact")) {
+            compact = 1;
+            continue;
+        }
+
+        if(!strcmp(argv[i], "--hud")) {
+            hud = 1;
+            continue;
+        }
+
+        if(!strcmp(argv[i], "--render") && i + 1 < argc) {
+            render_path = argv[++i];
+            continue;
+        }
+
+        if(!strcmp(argv[i], "--render-audio") && i + 1 < argc) {
+            audio_path = argv[++i];
+            continue;
+        }
+
+        if(!strcmp(argv[i], "--size") && i + 1 < argc) {
+            if(sscanf(argv[++i], "%dx%d", &screen_width, &screen_height) != 2 || screen_width < 2 || screen_height < 2) {
+                lprintf("--size takes WIDTHxHEIGHT");
+                return 1;
+            }
+            continue;
+        }
+
+        if(!strcmp(argv[i], "--fps") && i + 1 < argc) {
+            render_fps = (size_t)strtoul(argv[++i], NULL, 10);
+            if(!render_fps) {
+                lprintf("--fps takes a frame rate");
+                return 1;
+            }
+            continue;
+        }
+
+        if(!path) {
+            path = argv[i];
+            continue;
+        }
+
+        width_mod = (size_t)strtoul(argv[i], NULL, 10);
+        if(!width_mod)
+            width_mod = 1;
+    }
+
+    if(!path) {
         lprintf("argument required!");
         return 1;
     }
 
-    if(!drwav_init_file(&wav, argv[1], NULL)) {
-        lprintf("unable to open or read %s", argv[1]);
+    if(streaming && mapped) {
+        lprintf("--stream and --mmap can't be used together");
         return 1;
     }
 
-    g_state.sample_rate = wav.sampleRate;
-    g_state.samples = safe_malloc(wav.totalPCMFrameCount * wav.channels * sizeof(float));
-    g_state.num_samples = drwav_read_pcm_frames_f32(&wav, wav.totalPCMFrameCount, g_state.samples);
-    g_state.num_channels = wav.channels;
-    g_state.position = 0;
-
-    drwav_uninit(&wav);
+    if(streaming && resident) {
+        lprintf("--gpu needs the whole track and can't be used with --stream");
+        return 1;
+    }
 
-    if(argc >= 3) {
-        width_mod = (size_t)strtoul(argv[2], NULL, 10);
-        if(!width_mod)
-            width_mod = 1;
+    if(compact && (streaming || mapped)) {
+        lprintf("--compact only applies to a preloaded track");
+        return 1;
     }
 
-    g_wave_table_size = g_state.sample_rate / width_mod;
-    g_wave_table = safe_malloc(sizeof(vec2f_t) * g_wave_table_size);
+    if(audio_path && !render_path) {
+        lprintf("--render-audio goes with --render");
+        return 1;
+    }
 
-    pa_params.device = Pa_GetDefaultOutputDevice();
-    if(pa_params.device == paNoDevice) {
-        lprintf("pa: no output device");
+    /* The decoder thread paces itself on the audio clock. */
+    if(render_path && streaming) {
+        lprintf("--render can't keep up with --stream, use --mmap instead");
         return 1;
     }
 
-    pa_params.channelCount = (int)g_state.num_channels;
-    pa_params.sampleFormat = paFloat32;
-    pa_params.suggestedLatency = Pa_GetDeviceInfo(pa_params.device)->defaultLowOutputLatency;
-    pa_params.hostApiSpecificStreamInfo = NULL;
+    atomic_init(&g_state.seq, 0);
+    atomic_init(&g_state.position, 0);
+    atomic_init(&g_state.dac_frame, 0);
+    atomic_init(&g_state.dac_time, 0.0);
+    atomic_init(&g_state.seek, SIZE_MAX);
+    atomic_init(&g_state.paused, 0);
+    atomic_init(&g_state.loop, 0);
+    callback_stats_init(&g_state.stats);
+
+    if(mapped) {
+        if(!map_init(&g_state, path)) {
+            lprintf("unable to map or read %s", path);
+            return 1;
+        }
 
-    pa_err = Pa_OpenStream(&g_stream, NULL, &pa_params, (double)wav.sampleRate, paFramesPerBufferUnspecified, 0, &pa_callback, &g_state);
-    if(pa_err != paNoError)
-        goto on_pa_error;
+        g_window_frames = g_state.sample_rate / width_mod;
+    } else {
+        if(!drwav_init_file(&wav, path, NULL)) {
+            lprintf("unable to open or read %s", path);
+            return 1;
+        }
 
-    glfwSetErrorCallback(&on_error);
+        g_state.sample_rate = wav.sampleRate;
+        g_state.num_channels = wav.channels;
+        g_window_frames = g_state.sample_rate / width_mod;
+
+        if(streaming) {
+            /* The decoder thread keeps its own handle open. */
+            g_state.num_samples = (size_t)wav.totalPCMFrameCount;
+            drwav_uninit(&wav);
+            if(!ring_init(&g_state, path, g_window_frames)) {
+                lprintf("unable to start the decoder for %s", path);
+                return 1;
+            }
+        } else if(compact) {
+            load_compact(&g_state, &wav, path);
+            drwav_uninit(&wav);
+        } else {
+            g_state.samples = safe_malloc(wav.totalPCMFrameCount * wav.channels * sizeof(float));
+            load_frames(&g_state, &wav, path);
+            drwav_uninit(&wav);
+        }
+    }
 
-    if(!glfwInit()) {
-        lprintf("glfw: init failed");
-        return 1;
+    g_view_frames = g_window_frames;
+
+    g_trigger.mode = TRIGGER_OFF;
+    g_trigger.hysteresis = 0.02f;
+    g_trigger.last = SIZE_MAX;
+    g_trigger.found = SIZE_MAX;
+    g_trigger.scratch = safe_malloc(2 * TRIGGER_SPAN * sizeof(float));
+
+    /* The pyramid needs the whole track addressable. */
+    if(!g_state.ring && !(g_state.map && g_state.map->converted) && !pyramid_init(&g_pyramid))
+        lprintf("unable to start building the peak pyramid");
+
+    /* Rendering to a file needs no audio device. */
+    if(!render_path) {
+        pa_params.device = Pa_GetDefaultOutputDevice();
+        if(pa_params.device == paNoDevice) {
+            lprintf("pa: no output device");
+            return 1;
+        }
+
+        pa_params.channelCount = (int)g_state.num_channels;
+        pa_params.sampleFormat = paFloat32;
+        pa_params.suggestedLatency = Pa_GetDeviceInfo(pa_params.device)->defaultLowOutputLatency;
+        pa_params.hostApiSpecificStreamInfo = NULL;
+
+        pa_err = Pa_OpenStream(&g_stream, NULL, &pa_params, (double)g_state.sample_rate, paFramesPerBufferUnspecified, 0, &pa_callback, &g_state);
+        if(pa_err != paNoError)
+            goto on_pa_error;
     }
 
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_API);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    glfwSetErrorCallback(&on_error);
+
+    if(render_path) {
+        g_window = open_offscreen(screen_width, screen_height);
+        frame_period = 1.0 / (double)render_fps;
+    } else {
+        if(!glfwInit()) {
+            lprintf("glfw: init failed");
+            return 1;
+        }
+
+        context_hints();
+        monitor = glfwGetPrimaryMonitor();
+        vidmode = glfwGetVideoMode(monitor);
+        screen_width = vidmode->width;
+        screen_height = vidmode->height;
+        frame_period = 1.0 / (double)(vidmode->refreshRate > 0 ? vidmode->refreshRate : 60);
+        g_window = glfwCreateWindow(screen_width, screen_height, "scope", monitor, NULL);
+    }
 
-    monitor = glfwGetPrimaryMonitor();
-    vidmode = glfwGetVideoMode(monitor);
-    g_window = glfwCreateWindow(vidmode->width, vidmode->height, "scope", monitor, NULL);
     if(!g_window) {
         lprintf("glfw: window creation failed");
         return 1;
     }
 
+    g_wave_table_size = wave_table_size(screen_width);
+    spectrum_init(&g_spectrum, (size_t)screen_width);
+
     glfwSetInputMode(g_window, GLFW_CURSOR, GLFW_CURSOR_HIDDEN);
 
     glfwMakeContextCurrent(g_window);
-    glfwSwapInterval(1);
+    glfwSwapInterval(render_path ? 0 : 1);
 
     if(!gladLoadGL((GLADloadfunc)(&glfwGetProcAddress))) {
         lprintf("glad: loading failed");
@@ -301,9 +2481,76 @@ int main(int argc, char **argv)
         return 1;
     }
 
+    vert = make_shader(GL_VERTEX_SHADER, xy_vert_src);
+    frag = make_shader(GL_FRAGMENT_SHADER, frag_src);
+    g_xy_program = make_program(vert, frag);
+    if(!g_xy_program) {
+        lprintf("program compilation failed");
+        return 1;
+    }
+
+    vert = make_shader(GL_VERTEX_SHADER, spectrum_vert_src);
+    frag = make_shader(GL_FRAGMENT_SHADER, frag_src);
+    g_spectrum_program = make_program(vert, frag);
+    if(!g_spectrum_program) {
+        lprintf("program compilation failed");
+        return 1;
+    }
+
+    g_fft_program = make_program(make_shader(GL_COMPUTE_SHADER, fft_comp_src), 0);
+    if(!g_fft_program) {
+        lprintf("program compilation failed");
+        return 1;
+    }
+
+    g_phosphor_program = make_program(make_shader(GL_COMPUTE_SHADER, phosphor_comp_src), 0);
+    vert = make_shader(GL_VERTEX_SHADER, quad_vert_src);
+    frag = make_shader(GL_FRAGMENT_SHADER, phosphor_frag_src);
+    g_tone_program = make_program(vert, frag);
+    if(!g_phosphor_program || !g_tone_program) {
+        lprintf("program compilation failed");
+        return 1;
+    }
+
+    vert = make_shader(GL_VERTEX_SHADER, quad_vert_src);
+    frag = make_shader(GL_FRAGMENT_SHADER, waterfall_frag_src);
+    g_waterfall_program = make_program(vert, frag);
+    if(!g_waterfall_program) {
+        lprintf("program compilation failed");
+        return 1;
+    }
+
+    vert = make_shader(GL_VERTEX_SHADER, hud_vert_src);
+    frag = make_shader(GL_FRAGMENT_SHADER, hud_frag_src);
+    g_hud_program = make_program(vert, frag);
+    if(!g_hud_program) {
+        lprintf("program compilation failed");
+        return 1;
+    }
+
+    if(resident) {
+        vert = make_shader(GL_VERTEX_SHADER, track_vert_src);
+        frag = make_shader(GL_FRAGMENT_SHADER, frag_src);
+        g_track_program = make_program(vert, frag);
+        if(!g_track_program) {
+            lprintf("program compilation failed");
+            return 1;
+        }
+
+        if(!gpu_track_init(&g_track, g_window_frames)) {
+            lprintf("the scope window doesn't fit in a storage block");
+            return 1;
+        }
+    }
+
     glCreateBuffers(NUM_BUFS, g_bufs);
-    glNamedBufferStorage(g_bufs[BUF_SSBO], sizeof(vec2f_t) * g_wave_table_size, NULL, GL_DYNAMIC_STORAGE_BIT);
+    wave_ring_init(&g_wave_ring, sizeof(float) * g_wave_table_size * wave_table_lanes(&g_state));
     glNamedBufferStorage(g_bufs[BUF_UNIF], sizeof(ubo), NULL, GL_DYNAMIC_STORAGE_BIT);
+    glNamedBufferStorage(g_bufs[BUF_SPEC], sizeof(float) * 2 * g_spectrum.max_columns, NULL, GL_DYNAMIC_STORAGE_BIT);
+    glNamedBufferStorage(g_bufs[BUF_FFTI], sizeof(float) * g_state.num_channels << FFT_MAX_BITS, NULL, GL_DYNAMIC_STORAGE_BIT);
+    glNamedBufferStorage(g_bufs[BUF_FFTW], sizeof(vec2f_t) << FFT_MAX_BITS, NULL, 0);
+    glNamedBufferStorage(g_bufs[BUF_FFTB], sizeof(float) * (((size_t)1 << (FFT_MAX_BITS - 1)) + 1), NULL, 0);
+    glNamedBufferStorage(g_bufs[BUF_HUD], sizeof(g_profile.text), NULL, GL_DYNAMIC_STORAGE_BIT);
 
     /* To draw stuff OpenGL needs a valid VAO
      * bound to the state. We don't need any
@@ -311,55 +2558,270 @@ int main(int argc, char **argv)
      * manually or have them hardcoded. */
     glCreateVertexArrays(1, &g_vao);
 
+    /* Line edges fade out through the alpha. */
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    waterfall_init(&g_waterfall);
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &g_phosphor_image);
+    glTextureStorage2D(g_phosphor_image, 1, GL_R32UI, screen_width, screen_height);
+
     glfwSetKeyCallback(g_window, &on_key);
 
+    if(render_path) {
+        if(!video_init(&video, render_path, (size_t)screen_width, (size_t)screen_height, render_fps)) {
+            lprintf("unable to write %s", render_path);
+            return 1;
+        }
+
+        if(audio_path && !audio_init(&audio, audio_path, &g_state)) {
+            lprintf("unable to write %s", audio_path);
+            return 1;
+        }
+    }
+
+    /* Renders aren't paced, so nothing gets dropped. */
+    profile_init(&g_profile, render_path ? 0.0 : frame_period);
+    g_profile.shown = hud;
+
     pt = t = glfwGetTime();
     while(!glfwWindowShouldClose(g_window)) {
-        t = glfwGetTime();
-        dt = t - pt;
-        pt = t;
+        if(render_path) {
+            /* Fixed steps through the track, as fast
+             * as the frames can be drawn. */
+            dt = frame_period;
+            width = (int)video.width;
+            height = (int)video.height;
+            position = video.frames * g_state.sample_rate / render_fps;
+            if(position >= g_state.num_samples)
+                break;
+        } else {
+            t = glfwGetTime();
+            dt = t - pt;
+            pt = t;
+
+            /* Smoothed so that one late frame doesn't
+             * throw the swap time prediction off. */
+            if(dt > 0.0 && dt < 0.25)
+                frame_period += (dt - frame_period) * 0.05;
+
+            glfwGetFramebufferSize(g_window, &width, &height);
+
+            /* Show what will be audible when this frame
+             * is swapped in, about one frame from now. */
+            playhead = read_playhead(&g_state);
+            position = playhead.position;
+            if(Pa_IsStreamActive(g_stream) == 1)
+                position = predict_position(&playhead, Pa_GetStreamTime(g_stream) + frame_period);
+        }
 
-        glfwGetFramebufferSize(g_window, &width, &height);
-        glViewport(0, 0, width, height);
-        fill_signal_tab(width);
+        profile_frame(&g_profile);
+
+        /* The spectrum takes the bottom half if shown. */
+        trace_height = g_spectrum_view != SPECTRUM_HIDDEN ? height - height / 2 : height;
+
+        history = g_view_frames;
+        if(g_spectrum_view != SPECTRUM_HIDDEN && ((size_t)1 << g_spectrum.bits) > history)
+            history = (size_t)1 << g_spectrum.bits;
+        if(g_state.map)
+            map_prefetch(&g_state, position, history);
+
+        if(g_spectrum_view == SPECTRUM_LINE && g_gpu_fft) {
+            gpu_spectrum_update(&g_spectrum, position, (size_t)width, (float)dt);
+        } else if(g_spectrum_view == SPECTRUM_LINE) {
+            spectrum_update(&g_spectrum, position, (size_t)width, (float)dt);
+            glNamedBufferSubData(g_bufs[BUF_SPEC], 0, sizeof(float) * 2 * g_spectrum.num_columns, g_spectrum.columns);
+        }
+
+        if(g_spectrum_view == SPECTRUM_WATERFALL)
+            waterfall_update(&g_waterfall, &ubo, position);
+
+        count = 0;
+        g_wave_count = g_rms_count = g_lane_stride = 0;
+        profile_mark(&g_profile, TIMING_OTHER);
+        g_wave_table = wave_ring_acquire(&g_wave_ring);
+        profile_mark(&g_profile, TIMING_UPLOAD);
+        position = trigger_window(&g_trigger, position, g_view_frames);
+        if(position != SIZE_MAX) {
+            if(g_track.buffer)
+                count = gpu_track_update(&g_track, &ubo, position);
+            else if(g_xy || g_phosphor)
+                count = fill_frames(&ubo, position);
+            else
+                fill_signal_tab(&ubo, width, position);
+        }
+
+        profile_mark(&g_profile, TIMING_FILL);
 
+        if(ubo.lanes[0] != g_lanes)
+            set_lanes(&ubo, g_lanes);
+        ubo.lanes[1] = (GLuint)g_lane_stride;
         ubo.x_dt_yz_screen[0] = (float)dt;
         ubo.x_dt_yz_screen[1] = (float)width;
-        ubo.x_dt_yz_screen[2] = (float)height;
+        ubo.x_dt_yz_screen[2] = (float)trace_height;
+        ubo.line[0] = g_line_width;
+        ubo.storage[0] = (GLuint)g_state.format;
 
-        glNamedBufferSubData(g_bufs[BUF_SSBO], 0, sizeof(vec2f_t) * g_wave_table_size, g_wave_table);
         glNamedBufferSubData(g_bufs[BUF_UNIF], 0, sizeof(ubo), &ubo);
+        profile_mark(&g_profile, TIMING_UPLOAD);
 
+        glViewport(0, 0, width, height);
         glClearColor(0.0f, 0.0f, 0.0f, 1.0);
         glClear(GL_COLOR_BUFFER_BIT);
+        glViewport(0, height - trace_height, width, trace_height);
 
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, g_bufs[BUF_SSBO]);
+        if(g_track.buffer)
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, g_track.buffer);
+        else
+            wave_ring_bind(&g_wave_ring, 0);
         glBindBufferBase(GL_UNIFORM_BUFFER, 1, g_bufs[BUF_UNIF]);
 
         glBindVertexArray(g_vao);
 
-        glLineWidth(2.0f);
+        if(g_xy) {
+            /* Leading zeros would only pile up in the middle. */
+            glUseProgram(g_xy_program);
+            if(count)
+                draw_lines(ubo.track[1], count - ubo.track[1], 1);
+        } else if(g_phosphor) {
+            /* A frame's worth of fading, then the hits. */
+            glUseProgram(g_phosphor_program);
+            glBindImageTexture(0, g_phosphor_image, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+            glProgramUniform4f(g_phosphor_program, 1, (float)exp(-dt / PHOSPHOR_PERSISTENCE), 0.0f, 0.0f, 0.0f);
+            glProgramUniform4ui(g_phosphor_program, 0, 0, 0, 0, 0);
+            glDispatchCompute((GLuint)(((size_t)width * (size_t)trace_height + FFT_GROUP - 1) / FFT_GROUP), 1, 1);
+            glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+            if(count > 1) {
+                glProgramUniform4ui(g_phosphor_program, 0, 1, 0, 0, 0);
+                glDispatchCompute((GLuint)((count + FFT_GROUP - 1) / FFT_GROUP), (GLuint)g_lanes, 1);
+                glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+            }
+
+            /* Full brightness for a pixel that every frame
+             * of its column lands on, in steady state. */
+            glUseProgram(g_tone_program);
+            glProgramUniform4f(g_tone_program, 0, (float)(((double)count / (double)width + 1.0) / (1.0 - exp(-frame_period / PHOSPHOR_PERSISTENCE))), 0.0f, 0.0f, 0.0f);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        } else if(g_track.buffer) {
+            glUseProgram(g_track_program);
+            draw_lines(0, count, g_lanes);
+        } else {
+            glUseProgram(g_program);
+
+            /* The RMS band goes underneath the peaks. */
+            if(g_rms_count) {
+                ubo.xyz_color[0] = 0.4f;
+                ubo.xyz_color[1] = 0.4f;
+                ubo.xyz_color[2] = 0.4f;
+                glNamedBufferSubData(g_bufs[BUF_UNIF], 0, sizeof(ubo), &ubo);
+                draw_lines(g_wave_count, g_rms_count, g_lanes);
+
+                ubo.xyz_color[0] = 1.0f;
+                ubo.xyz_color[1] = 1.0f;
+                ubo.xyz_color[2] = 1.0f;
+                glNamedBufferSubData(g_bufs[BUF_UNIF], 0, sizeof(ubo), &ubo);
+            }
+
+            draw_lines(0, g_wave_count, g_lanes);
+        }
+
+        if(g_spectrum_view == SPECTRUM_WATERFALL) {
+            glViewport(0, 0, width, height - trace_height);
+            glUseProgram(g_waterfall_program);
+            glBindTextureUnit(0, g_waterfall.texture);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        }
+
+        /* Peak hold in grey behind the levels. */
+        if(g_spectrum_view == SPECTRUM_LINE && g_spectrum.num_columns >= 2) {
+            glViewport(0, 0, width, height - trace_height);
+            glUseProgram(g_spectrum_program);
+            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, g_bufs[BUF_SPEC], 0, (GLsizeiptr)(sizeof(float) * 2 * g_spectrum.num_columns));
+
+            ubo.x_dt_yz_screen[2] = (float)(height - trace_height);
+            ubo.xyz_color[0] = 0.4f;
+            ubo.xyz_color[1] = 0.4f;
+            ubo.xyz_color[2] = 0.4f;
+            glNamedBufferSubData(g_bufs[BUF_UNIF], 0, sizeof(ubo), &ubo);
+            draw_lines(g_spectrum.num_columns, g_spectrum.num_columns, 1);
+
+            ubo.xyz_color[0] = 1.0f;
+            ubo.xyz_color[1] = 1.0f;
+            ubo.xyz_color[2] = 1.0f;
+            glNamedBufferSubData(g_bufs[BUF_UNIF], 0, sizeof(ubo), &ubo);
+            draw_lines(0, g_spectrum.num_columns, 1);
+        }
 
-        glUseProgram(g_program);
+        if(g_profile.shown) {
+            if(g_profile.start >= g_profile.refresh) {
+                hud_update(&g_profile, &g_state.stats, g_bufs[BUF_HUD]);
+                g_profile.refresh = g_profile.start + HUD_REFRESH;
+            }
+            hud_draw(width, height);
+        }
 
-        glDrawArrays(GL_LINE_STRIP, 0, (GLuint)g_wave_table_size);
+        profile_end(&g_profile);
+        wave_ring_release(&g_wave_ring);
+
+        /* The audio of a frame lasts until the next one. */
+        if(render_path) {
+            video_capture(&video);
+            if(audio_path) {
+                position = video.frames * g_state.sample_rate / render_fps;
+                if(g_state.map)
+                    map_convert(&g_state, audio.position, position);
+                audio_queue(&audio, &g_state, position);
+                if(atomic_load_explicit(&audio.failed, memory_order_acquire))
+                    break;
+            }
+            continue;
+        }
 
+        profile_mark(&g_profile, TIMING_OTHER);
         glfwSwapBuffers(g_window);
+        profile_mark(&g_profile, TIMING_SWAP);
         glfwPollEvents();
     }
 
+    if(render_path)
+        video_finish(&video);
+
+    if(audio_path && !audio_finish(&audio))
+        exit_code = 1;
+
 normal_quit:
     glDeleteVertexArrays(1, &g_vao);
     glDeleteBuffers(NUM_BUFS, g_bufs);
+    profile_shutdown(&g_profile);
+    wave_ring_shutdown(&g_wave_ring);
+    glDeleteBuffers(1, &g_track.buffer);
+    glDeleteTextures(1, &g_phosphor_image);
+    waterfall_shutdown(&g_waterfall);
+    glDeleteProgram(g_hud_program);
+    glDeleteProgram(g_waterfall_program);
+    glDeleteProgram(g_tone_program);
+    glDeleteProgram(g_phosphor_program);
+    glDeleteProgram(g_fft_program);
+    glDeleteProgram(g_spectrum_program);
+    glDeleteProgram(g_xy_program);
+    glDeleteProgram(g_track_program);
     glDeleteProgram(g_program);
     glfwDestroyWindow(g_window);
     glfwTerminate();
-    Pa_CloseStream(g_stream);
-    free(g_wave_table);
+    if(g_stream) {
+        Pa_CloseStream(g_stream);
+        print_callback_stats(&g_state.stats);
+    }
+    pyramid_shutdown(&g_pyramid);
+    ring_shutdown(&g_state);
+    map_shutdown(&g_state);
+    spectrum_shutdown(&g_spectrum);
+    free(g_trigger.scratch);
     free(g_state.samples);
     Pa_Terminate();
 
-    return 0;
+    return exit_code;
 
 on_pa_error:
     /* This is a little hacky but it's just a better
@@ -0,0 +1,432 @@
+/* Measures the per-frame work of scope on the CPU:
+ * building the wave table, copying the window out
+ * of the track, the audio callback and the dr_wav
+ * decoding.
+ * Runs on synthetic tracks and on any files given,
+ * prints one JSON object to stdout. */
+#define _USE_MATH_DEFINES 1
+
+#include <stdio.h>
+
+#include "scope_core.h"
+
+#ifndef SCOPE_VERSION
+#define SCOPE_VERSION "unknown"
+#endif
+
+#define BENCH_WIDTH 1920 /* screen columns for the wave table   */
+#define BENCH_FPS 60     /* playhead step between frames        */
+#define BENCH_CALLBACK 512 /* frames per audio callback         */
+#define BENCH_KERNEL_SAMPLES 1048576
+#define BENCH_MIN_TIME 0.2 /* seconds each kernel runs at least */
+
+static const size_t g_bench_channels[] = { 1, 2, 8 };
+static const size_t g_bench_rates[] = { 44100, 48000, 96000, 192000 };
+static const size_t g_bench_width_mods[] = { 1, 4, 16 };
+
+static int g_bench_first = 1;
+
+struct bench_source {
+    const char *name;
+    size_t channels;
+    size_t rate;
+    size_t width_mod;
+    size_t lanes;
+};
+
+struct bench_kernel {
+    const char *name;
+    void (*run)(void *out, const void *in, size_t count);
+    size_t in_size;
+    size_t out_size;
+};
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* `frames` is how many track frames the bench went
+ * through: the window once per call for the per-frame
+ * benches, the frames played for the callback, the
+ * frames decoded for the loaders and the samples
+ * converted for the dr_wav kernels. frames_per_s is that
+ * over the time taken, not a playback or upload rate.
+ * `samples` is frames times channels, `bytes` what
+ * was read and written in total. */
+static void bench_report(const char *bench, const struct bench_source *source, size_t calls, double seconds, size_t frames, size_t samples, size_t bytes)
+{
+    const char *c;
+
+    if(seconds <= 0.0)
+        seconds = 1e-9;
+
+    printf("%s\n    {\"bench\": \"%s\", \"source\": \"", g_bench_first ? "" : ",", bench);
+    for(c = source->name; *c; c++) {
+        if(*c == '"' || *c == '\\')
+            putchar('\\');
+        putchar(*c);
+    }
+
+    printf("\", \"channels\": %zu, \"rate\": %zu, \"width_mod\": %zu, \"lanes\": %zu, ", source->channels, source->rate, source->width_mod, source->lanes);
+    printf("\"calls\": %zu, \"seconds\": %.6f, \"ns_per_call\": %.1f, \"ns_per_sample\": %.4f, ", calls, seconds, seconds * 1e9 / (double)(calls ? calls : 1), seconds * 1e9 / (double)(samples ? samples : 1));
+    printf("\"frames_per_s\": %.0f, \"bytes\": %zu, \"bytes_per_s\": %.0f}", (double)frames / seconds, bytes, (double)bytes / seconds);
+    g_bench_first = 0;
+}
+
+/* A sine per channel at its own pitch over a bit of
+ * noise, the shape of the data doesn't change the
+ * work much but zeros might. */
+static void bench_synthesize(size_t channels, size_t rate, size_t seconds)
+{
+    size_t i, j;
+    float *out;
+    unsigned int seed = 1;
+
+    g_state.sample_rate = rate;
+    g_state.num_channels = channels;
+    g_state.num_samples = rate * seconds;
+    g_state.format = SAMPLE_F32;
+    g_state.samples = safe_malloc(g_state.num_samples * channels * sizeof(float));
+
+    out = g_state.samples;
+    for(i = 0; i < g_state.num_samples; i++) {
+        for(j = 0; j < channels; j++) {
+            seed = seed * 1664525u + 1013904223u;
+            *out++ = 0.5f * sinf((float)(2.0 * M_PI * 110.0 * (double)(j + 1) * (double)i / (double)rate)) + (float)(seed >> 8) / 16777216.0f * 0.1f - 0.05f;
+        }
+    }
+}
+
+/* Same setup main does for the window and the wave
+ * table. */
+static void bench_window(size_t width_mod)
+{
+    g_window_frames = g_view_frames = g_state.sample_rate / width_mod;
+    g_wave_table_size = wave_table_size(BENCH_WIDTH);
+    free(g_wave_table);
+    g_wave_table = safe_malloc(sizeof(float) * g_wave_table_size * wave_table_lanes(&g_state));
+}
+
+/* One call per 60 Hz frame from the first full
+ * window to the end of the track. */
+static void bench_signal_tab(struct bench_source *source)
+{
+    double t;
+    size_t position, calls = 0, bytes = 0;
+    struct ubo_data ubo;
+    size_t step = g_state.sample_rate / BENCH_FPS;
+
+    memset(&ubo, 0, sizeof(ubo));
+    g_lanes = source->lanes;
+
+    t = bench_now();
+    for(position = g_window_frames; position <= g_state.num_samples; position += step) {
+        fill_signal_tab(&ubo, BENCH_WIDTH, position);
+        bytes += g_lane_stride * g_lanes * sizeof(float);
+        calls++;
+    }
+
+    t = bench_now() - t;
+    bench_report("fill_signal_tab", source, calls, t, calls * g_window_frames, calls * g_window_frames * g_state.num_channels, bytes);
+    g_lanes = 1;
+}
+
+/* The copy fill_frames does for the XY and phosphor
+ * modes every frame, into plain memory here. The GL
+ * upload itself isn't part of it. */
+static void bench_copy(struct bench_source *source)
+{
+    double t;
+    size_t position, calls = 0;
+    size_t step = g_state.sample_rate / BENCH_FPS;
+
+    t = bench_now();
+    for(position = g_window_frames; position <= g_state.num_samples; position += step) {
+        copy_frames(g_wave_table, position - g_window_frames, position);
+        calls++;
+    }
+
+    t = bench_now() - t;
+    bench_report("copy", source, calls, t, calls * g_window_frames, calls * g_window_frames * g_state.num_channels, calls * g_window_frames * frame_bytes(&g_state) * 2);
+}
+
+/* Plays the whole track through the callback. */
+static void bench_callback(struct bench_source *source)
+{
+    double t;
+    size_t calls = 0;
+    float *out = safe_malloc(BENCH_CALLBACK * g_state.num_channels * sizeof(float));
+    PaStreamCallbackTimeInfo time_info = { 0.0, 0.0, 0.0 };
+
+    atomic_store(&g_state.position, 0);
+    atomic_store(&g_state.seek, SIZE_MAX);
+    atomic_store(&g_state.paused, 0);
+    atomic_store(&g_state.loop, 0);
+
+    t = bench_now();
+    while(!atomic_load_explicit(&g_state.paused, memory_order_relaxed)) {
+        pa_callback(NULL, out, BENCH_CALLBACK, &time_info, 0, &g_state);
+        time_info.outputBufferDacTime += (double)BENCH_CALLBACK / (double)g_state.sample_rate;
+        calls++;
+    }
+
+    t = bench_now() - t;
+    bench_report("pa_callback", source, calls, t, g_state.num_samples, g_state.num_samples * g_state.num_channels,
+        g_state.num_samples * (frame_bytes(&g_state) + g_state.num_channels * sizeof(float)));
+    free(out);
+}
+
+/* The pyramid is finished before timing starts,
+ * as it is for all but the first moments of a run. */
+static void bench_track(const char *name)
+{
+    size_t i;
+    struct bench_source source;
+    const struct timespec nap = { 0, 1000000 };
+
+    source.name = name;
+    source.channels = g_state.num_channels;
+    source.rate = g_state.sample_rate;
+
+    if(!pyramid_init(&g_pyramid)) {
+        lprintf("bench: unable to build the peak pyramid");
+        return;
+    }
+    while(!atomic_load_explicit(&g_pyramid.ready, memory_order_acquire))
+        thrd_sleep(&nap, NULL);
+
+    for(i = 0; i < sizeof(g_bench_width_mods) / sizeof(g_bench_width_mods[0]); i++) {
+        source.width_mod = g_bench_width_mods[i];
+        source.lanes = 1;
+        if(g_state.sample_rate / source.width_mod > g_state.num_samples) {
+            lprintf("bench: %s too short for width_mod %zu", name, source.width_mod);
+            continue;
+        }
+
+        bench_window(source.width_mod);
+        bench_signal_tab(&source);
+        if(g_state.num_channels > 1) {
+            source.lanes = g_state.num_channels < MAX_LANES ? g_state.num_channels : MAX_LANES;
+            bench_signal_tab(&source);
+            source.lanes = 1;
+        }
+
+        bench_copy(&source);
+    }
+
+    pyramid_shutdown(&g_pyramid);
+    free(g_wave_table);
+    g_wave_table = NULL;
+
+    source.width_mod = 0;
+    bench_callback(&source);
+}
+
+static void kernel_u8_to_f32(void *out, const void *in, size_t count) { drwav_u8_to_f32(out, in, count); }
+static void kernel_s16_to_f32(void *out, const void *in, size_t count) { drwav_s16_to_f32(out, in, count); }
+static void kernel_s24_to_f32(void *out, const void *in, size_t count) { drwav_s24_to_f32(out, in, count); }
+static void kernel_s32_to_f32(void *out, const void *in, size_t count) { drwav_s32_to_f32(out, in, count); }
+static void kernel_u8_to_s16(void *out, const void *in, size_t count) { drwav_u8_to_s16(out, in, count); }
+static void kernel_s24_to_s16(void *out, const void *in, size_t count) { drwav_s24_to_s16(out, in, count); }
+static void kernel_s32_to_s16(void *out, const void *in, size_t count) { drwav_s32_to_s16(out, in, count); }
+static void kernel_f32_to_s16(void *out, const void *in, size_t count) { drwav_f32_to_s16(out, in, count); }
+static void kernel_u8_to_s32(void *out, const void *in, size_t count) { drwav_u8_to_s32(out, in, count); }
+static void kernel_s16_to_s32(void *out, const void *in, size_t count) { drwav_s16_to_s32(out, in, count); }
+static void kernel_s24_to_s32(void *out, const void *in, size_t count) { drwav_s24_to_s32(out, in, count); }
+static void kernel_f32_to_s32(void *out, const void *in, size_t count) { drwav_f32_to_s32(out, in, count); }
+
+static const struct bench_kernel g_bench_kernels[] = {
+    { "drwav_u8_to_f32", &kernel_u8_to_f32, 1, 4 },
+    { "drwav_s16_to_f32", &kernel_s16_to_f32, 2, 4 },
+    { "drwav_s24_to_f32", &kernel_s24_to_f32, 3, 4 },
+    { "drwav_s32_to_f32", &kernel_s32_to_f32, 4, 4 },
+    { "drwav_u8_to_s16", &kernel_u8_to_s16, 1, 2 },
+    { "drwav_s24_to_s16", &kernel_s24_to_s16, 3, 2 },
+    { "drwav_s32_to_s16", &kernel_s32_to_s16, 4, 2 },
+    { "drwav_f32_to_s16", &kernel_f32_to_s16, 4, 2 },
+    { "drwav_u8_to_s32", &kernel_u8_to_s32, 1, 4 },
+    { "drwav_s16_to_s32", &kernel_s16_to_s32, 2, 4 },
+    { "drwav_s24_to_s32", &kernel_s24_to_s32, 3, 4 },
+    { "drwav_f32_to_s32", &kernel_f32_to_s32, 4, 4 }
+};
+
+/* Floats stay within [-1, 1] so that the float
+ * kernels don't all take the clipping path. */
+static void bench_kernels(void)
+{
+    size_t i, calls;
+    double t;
+    unsigned int seed = 1;
+    struct bench_source source = { "kernel", 1, 0, 0, 0 };
+    unsigned char *in = safe_malloc(BENCH_KERNEL_SAMPLES * 4);
+    float *floats = (float *)in;
+    void *out = safe_malloc(BENCH_KERNEL_SAMPLES * 4);
+
+    for(i = 0; i < BENCH_KERNEL_SAMPLES * 4; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        in[i] = (unsigned char)(seed >> 24);
+    }
+
+    for(i = 0; i < sizeof(g_bench_kernels) / sizeof(g_bench_kernels[0]); i++) {
+        const struct bench_kernel *kernel = &g_bench_kernels[i];
+        size_t j;
+
+        if(!strncmp(kernel->name, "drwav_f32", 9)) {
+            for(j = 0; j < BENCH_KERNEL_SAMPLES; j++) {
+                seed = seed * 1664525u + 1013904223u;
+                floats[j] = (float)(seed >> 8) / 8388608.0f - 1.0f;
+            }
+        }
+
+        calls = 0;
+        t = bench_now();
+        do {
+            kernel->run(out, in, BENCH_KERNEL_SAMPLES);
+            calls++;
+        } while(bench_now() - t < BENCH_MIN_TIME);
+
+        t = bench_now() - t;
+        bench_report(kernel->name, &source, calls, t, calls * BENCH_KERNEL_SAMPLES, calls * BENCH_KERNEL_SAMPLES, calls * BENCH_KERNEL_SAMPLES * (kernel->in_size + kernel->out_size));
+    }
+
+    free(out);
+    free(in);
+}
+
+/* Full decodes of the synthetic track written as
+ * 16- and 24-bit PCM to memory, through the same
+ * drwav_read_pcm_frames_f32 the loader uses. */
+static void bench_decode(size_t bits)
+{
+    drwav wav;
+    drwav_data_format format;
+    void *data = NULL;
+    size_t i, size = 0, calls = 0;
+    int32_t *pcm;
+    float *out;
+    double t;
+    struct bench_source source = { bits == 16 ? "synthetic s16" : "synthetic s24", g_state.num_channels, g_state.sample_rate, 0, 0 };
+    size_t count = g_state.num_samples * g_state.num_channels;
+
+    format.container = drwav_container_riff;
+    format.format = DR_WAVE_FORMAT_PCM;
+    format.channels = (drwav_uint32)g_state.num_channels;
+    format.sampleRate = (drwav_uint32)g_state.sample_rate;
+    format.bitsPerSample = (drwav_uint32)bits;
+
+    pcm = safe_malloc(count * sizeof(int32_t));
+    drwav_f32_to_s32(pcm, g_state.samples, count);
+    for(i = 0; i < count * bits / 8; i++)
+        ((unsigned char *)pcm)[i] = ((unsigned char *)pcm)[i / (bits / 8) * 4 + 4 - bits / 8 + i % (bits / 8)];
+
+    if(!drwav_init_memory_write(&wav, &data, &size, &format, NULL)) {
+        free(pcm);
+        return;
+    }
+    drwav_write_pcm_frames(&wav, g_state.num_samples, pcm);
+    drwav_uninit(&wav);
+    free(pcm);
+
+    out = safe_malloc(count * sizeof(float));
+    t = bench_now();
+    do {
+        if(!drwav_init_memory(&wav, data, size, NULL))
+            break;
+        drwav_read_pcm_frames_f32(&wav, g_state.num_samples, out);
+        drwav_uninit(&wav);
+        calls++;
+    } while(bench_now() - t < BENCH_MIN_TIME);
+
+    t = bench_now() - t;
+    bench_report("decode", &source, calls, t, calls * g_state.num_samples, calls * count, calls * (size + count * sizeof(float)));
+    free(out);
+    drwav_free(data, NULL);
+}
+
+/* Real files go through the parallel loader first. */
+static int bench_file(const char *path)
+{
+    drwav wav;
+    double t;
+    struct bench_source source;
+
+    if(!drwav_init_file(&wav, path, NULL)) {
+        lprintf("bench: unable to open or read %s", path);
+        return 0;
+    }
+
+    g_state.sample_rate = wav.sampleRate;
+    g_state.num_channels = wav.channels;
+    g_state.format = SAMPLE_F32;
+    g_state.samples = safe_malloc(wav.totalPCMFrameCount * wav.channels * sizeof(float));
+
+    t = bench_now();
+    load_frames(&g_state, &wav, path);
+    t = bench_now() - t;
+    drwav_uninit(&wav);
+
+    source.name = path;
+    source.channels = g_state.num_channels;
+    source.rate = g_state.sample_rate;
+    source.width_mod = 0;
+    source.lanes = 0;
+    bench_report("load", &source, 1, t, g_state.num_samples, g_state.num_samples * g_state.num_channels, g_state.num_samples * g_state.num_channels * sizeof(float));
+
+    if(g_state.num_samples)
+        bench_track(path);
+    free(g_state.samples);
+    g_state.samples = NULL;
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    int i;
+    size_t c, r, seconds = 10;
+
+    atomic_init(&g_state.seq, 0);
+    atomic_init(&g_state.position, 0);
+    atomic_init(&g_state.dac_frame, 0);
+    atomic_init(&g_state.dac_time, 0.0);
+    atomic_init(&g_state.seek, SIZE_MAX);
+    atomic_init(&g_state.paused, 0);
+    atomic_init(&g_state.loop, 0);
+    callback_stats_init(&g_state.stats);
+
+    for(i = 1; i < argc; i++) {
+        if(!strcmp(argv[i], "--seconds") && i + 1 < argc) {
+            seconds = (size_t)strtoul(argv[++i], NULL, 10);
+            if(!seconds)
+                seconds = 1;
+        }
+    }
+
+    printf("{\n  \"version\": \"%s\",\n  \"results\": [", SCOPE_VERSION);
+
+    bench_kernels();
+
+    for(c = 0; c < sizeof(g_bench_channels) / sizeof(g_bench_channels[0]); c++) {
+        for(r = 0; r < sizeof(g_bench_rates) / sizeof(g_bench_rates[0]); r++) {
+            bench_synthesize(g_bench_channels[c], g_bench_rates[r], seconds);
+            bench_track("synthetic");
+            bench_decode(16);
+            bench_decode(24);
+            free(g_state.samples);
+            g_state.samples = NULL;
+        }
+    }
+
+    for(i = 1; i < argc; i++) {
+        if(!strcmp(argv[i], "--seconds")) {
+            i++;
+            continue;
+        }
+        bench_file(argv[i]);
+    }
+
+    printf("\n  ]\n}\n");
+    return 0;
+}
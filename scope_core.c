@@ -0,0 +1,1098 @@
+#define _USE_MATH_DEFINES 1
+#define DR_WAV_IMPLEMENTATION 1
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "scope_core.h"
+
+/* A range of a preloaded track decoded by a thread
+ * with a handle of its own, straight into place. */
+struct load_range {
+    struct pa_state *state;
+    const char *path;
+    size_t first;
+    size_t count;
+    size_t done;
+    thrd_t thread;
+    int started;
+};
+
+static char g_logbuf[4096] = { 0 };
+struct pa_state g_state = { 0 };
+struct peak_pyramid g_pyramid = { 0 };
+float *g_wave_table = NULL;
+size_t g_wave_table_size = 0;
+size_t g_wave_count = 0;
+size_t g_rms_count = 0;
+size_t g_lanes = 1;
+size_t g_lane_stride = 0;
+size_t g_window_frames = 0;
+size_t g_view_frames = 0;
+
+#ifdef _WIN32
+/* Fixed at boot, read once by callback_stats_init so
+ * the callback only has to query the counter. */
+static uint64_t g_clock_frequency = 1;
+#endif
+
+static void lvprintf(const char *fmt, va_list va)
+{
+    vsnprintf(g_logbuf, sizeof(g_logbuf), fmt, va);
+    fprintf(stderr, "%s\r\n", g_logbuf);
+}
+
+void lprintf(const char *fmt, ...)
+{
+    va_list va;
+    va_start(va, fmt);
+    lvprintf(fmt, va);
+    va_end(va);
+}
+
+void *safe_malloc(size_t n)
+{
+    void *block = malloc(n);
+    if(!block) {
+        lprintf("out of memory!");
+        abort();
+    }
+
+    return block;
+}
+
+/* Rounds to nearest even, anything past the half
+ * range becomes an infinity. */
+static uint16_t half_from_float(float f)
+{
+    uint32_t bits, mant, rest, halfway;
+    uint16_t sign, h;
+    int exp, shift;
+
+    memcpy(&bits, &f, sizeof(bits));
+    sign = (uint16_t)((bits >> 16) & 0x8000u);
+    exp = (int)((bits >> 23) & 0xffu) - 127 + 15;
+    mant = bits & 0x7fffffu;
+
+    if(((bits >> 23) & 0xffu) == 0xffu)
+        return sign | 0x7c00u | (mant ? 0x200u : 0);
+    if(exp >= 31)
+        return sign | 0x7c00u;
+
+    if(exp <= 0) {
+        if(exp < -10)
+            return sign;
+        mant |= 0x800000u;
+        shift = 14 - exp;
+    } else {
+        mant |= (uint32_t)exp << 23;
+        shift = 13;
+    }
+
+    /* A carry out of the mantissa bumps the exponent,
+     * which is exactly what rounding up should do. */
+    h = (uint16_t)(mant >> shift);
+    rest = mant & ((1u << shift) - 1);
+    halfway = 1u << (shift - 1);
+    if(rest > halfway || (rest == halfway && (h & 1)))
+        h++;
+    return sign | h;
+}
+
+static void ring_publish(struct decode_ring *ring, size_t base, size_t head)
+{
+    unsigned int seq = atomic_load_explicit(&ring->seq, memory_order_relaxed);
+    atomic_store_explicit(&ring->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&ring->base, base, memory_order_relaxed);
+    atomic_store_explicit(&ring->head, head, memory_order_relaxed);
+    atomic_store_explicit(&ring->seq, seq + 2, memory_order_release);
+}
+
+static void ring_range(struct decode_ring *ring, size_t *base, size_t *head)
+{
+    unsigned int seq;
+    do {
+        seq = atomic_load_explicit(&ring->seq, memory_order_acquire);
+        *base = atomic_load_explicit(&ring->base, memory_order_relaxed);
+        *head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+    } while((seq & 1) || seq != atomic_load_explicit(&ring->seq, memory_order_relaxed));
+}
+
+/* One past the last frame after `position` that can
+ * be read right now, `position` itself if none can. */
+static size_t frames_ready(struct pa_state *state, size_t position)
+{
+    size_t base, head, block;
+
+    if(state->ring) {
+        ring_range(state->ring, &base, &head);
+        if(position < base || position >= head)
+            return position;
+        return head < state->num_samples ? head : state->num_samples;
+    }
+
+    if(state->map && state->map->converted) {
+        block = position / MAP_BLOCK;
+        while(block < state->map->num_blocks && atomic_load_explicit(&state->map->converted[block], memory_order_acquire))
+            block++;
+        head = block * MAP_BLOCK;
+        return head > position ? (head < state->num_samples ? head : state->num_samples) : position;
+    }
+
+    return state->num_samples;
+}
+
+/* The oldest frame the render thread may look at. */
+size_t frames_base(struct pa_state *state)
+{
+    size_t base, head;
+    if(!state->ring)
+        return 0;
+    ring_range(state->ring, &base, &head);
+    return base;
+}
+
+static void publish_playhead(struct pa_state *state, size_t position, size_t dac_frame, double dac_time)
+{
+    unsigned int seq = atomic_load_explicit(&state->seq, memory_order_relaxed);
+    atomic_store_explicit(&state->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&state->position, position, memory_order_relaxed);
+    atomic_store_explicit(&state->dac_frame, dac_frame, memory_order_relaxed);
+    atomic_store_explicit(&state->dac_time, dac_time, memory_order_relaxed);
+    atomic_store_explicit(&state->seq, seq + 2, memory_order_release);
+}
+
+struct playhead read_playhead(struct pa_state *state)
+{
+    unsigned int seq;
+    struct playhead head;
+    do {
+        seq = atomic_load_explicit(&state->seq, memory_order_acquire);
+        head.position = atomic_load_explicit(&state->position, memory_order_relaxed);
+        head.dac_frame = atomic_load_explicit(&state->dac_frame, memory_order_relaxed);
+        head.dac_time = atomic_load_explicit(&state->dac_time, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+    } while((seq & 1) || seq != atomic_load_explicit(&state->seq, memory_order_relaxed));
+    return head;
+}
+
+/* The frame that will be leaving the DAC at `when`,
+ * extrapolated from the last buffer the callback
+ * produced. It may be behind `position` by up to the
+ * output latency and is never allowed to run more
+ * than one buffer ahead of it, so a stalled or paused
+ * stream doesn't make the picture drift away. */
+size_t predict_position(const struct playhead *head, double when)
+{
+    double offset;
+    size_t advance;
+
+    /* No timing from the host or the buffer wrapped around for a loop. */
+    if(head->dac_time <= 0.0 || head->position < head->dac_frame)
+        return head->position;
+
+    advance = head->position - head->dac_frame;
+    offset = (when - head->dac_time) * (double)g_state.sample_rate;
+    if(offset < -(double)head->dac_frame)
+        return 0;
+    if(offset > (double)(advance * 2))
+        offset = (double)(advance * 2);
+
+    advance = (size_t)((double)head->dac_frame + offset);
+    return advance < g_state.num_samples ? advance : g_state.num_samples;
+}
+
+void request_seek(struct pa_state *state, size_t position)
+{
+    if(position > state->num_samples)
+        position = state->num_samples;
+    atomic_store_explicit(&state->seek, position, memory_order_release);
+}
+
+/* The frame as the callback plays it. */
+void output_frame(const struct pa_state *state, size_t frame, float *out)
+{
+    size_t j;
+    const void *samples = frame_at(state, frame);
+    for(j = 0; j < state->num_channels; j++)
+        out[j] = frame_sample(state, samples, j) * OUTPUT_GAIN;
+}
+
+/* Peaks come in groups: one for each channel that
+ * can have a lane of its own and, when there is more
+ * than one channel, the mix of all of them last. */
+static size_t peak_lanes(const struct pa_state *state)
+{
+    size_t lanes = state->num_channels < MAX_LANES ? state->num_channels : MAX_LANES;
+    return state->num_channels > 1 ? lanes + 1 : 1;
+}
+
+static void peak_add(struct peak *peak, float v)
+{
+    if(v < peak->min)
+        peak->min = v;
+    if(v > peak->max)
+        peak->max = v;
+    peak->ms += v * v;
+}
+
+/* Goes through the frames once and fills a whole
+ * group of peaks, so that every channel is only read
+ * from its frame rather than gathered on its own. */
+static void scan_peaks(const struct pa_state *state, size_t first, size_t count, struct peak *out)
+{
+    size_t i, j;
+    float v, sum;
+    const void *frame;
+    size_t lanes = peak_lanes(state);
+    size_t channels = lanes > 1 ? lanes - 1 : 1;
+
+    for(j = 0; j < lanes; j++) {
+        out[j].min = 0.0f;
+        out[j].max = 0.0f;
+        out[j].ms = 0.0f;
+    }
+
+    if(first >= state->num_samples)
+        return;
+    if(count > state->num_samples - first)
+        count = state->num_samples - first;
+
+    for(j = 0; j < lanes; j++) {
+        out[j].min = INFINITY;
+        out[j].max = -INFINITY;
+    }
+
+    for(i = 0; i < count; i++) {
+        frame = frame_at(state, first + i);
+        sum = 0.0f;
+        for(j = 0; j < state->num_channels; j++) {
+            v = frame_sample(state, frame, j);
+            if(j < channels)
+                peak_add(&out[j], v);
+            sum += v;
+        }
+        if(lanes > 1)
+            peak_add(&out[lanes - 1], sum / (float)state->num_channels);
+    }
+
+    for(j = 0; j < lanes; j++)
+        out[j].ms /= (float)count;
+}
+
+static int pyramid_thread(void *arg)
+{
+    size_t i, j, level;
+    const struct peak *src;
+    struct peak *dst;
+    struct peak_pyramid *pyramid = arg;
+    size_t lanes = peak_lanes(&g_state);
+
+    for(i = 0; i < pyramid->counts[0]; i++) {
+        if(!(i % 4096) && atomic_load_explicit(&pyramid->quit, memory_order_relaxed))
+            return 0;
+        scan_peaks(&g_state, i * PYRAMID_BASE, PYRAMID_BASE, &pyramid->levels[0][i * lanes]);
+    }
+
+    for(level = 1; level < pyramid->num_levels; level++) {
+        for(i = 0; i < pyramid->counts[level]; i++) {
+            src = pyramid->levels[level - 1] + i * 2 * lanes;
+            dst = pyramid->levels[level] + i * lanes;
+            memcpy(dst, src, lanes * sizeof(struct peak));
+            if(i * 2 + 1 >= pyramid->counts[level - 1])
+                continue;
+            for(j = 0; j < lanes; j++) {
+                if(src[lanes + j].min < dst[j].min)
+                    dst[j].min = src[lanes + j].min;
+                if(src[lanes + j].max > dst[j].max)
+                    dst[j].max = src[lanes + j].max;
+                dst[j].ms = (dst[j].ms + src[lanes + j].ms) * 0.5f;
+            }
+        }
+    }
+
+    atomic_store_explicit(&pyramid->ready, 1, memory_order_release);
+    return 0;
+}
+
+int pyramid_init(struct peak_pyramid *pyramid)
+{
+    size_t i, total;
+    struct peak *storage;
+    size_t lanes = peak_lanes(&g_state);
+
+    pyramid->counts[0] = (g_state.num_samples + PYRAMID_BASE - 1) / PYRAMID_BASE;
+    pyramid->num_levels = 1;
+    total = pyramid->counts[0];
+    while(pyramid->counts[pyramid->num_levels - 1] > 1 && pyramid->num_levels < PYRAMID_MAX_LEVELS) {
+        pyramid->counts[pyramid->num_levels] = (pyramid->counts[pyramid->num_levels - 1] + 1) / 2;
+        total += pyramid->counts[pyramid->num_levels];
+        pyramid->num_levels++;
+    }
+
+    storage = safe_malloc(total * lanes * sizeof(struct peak));
+    for(i = 0; i < pyramid->num_levels; i++) {
+        pyramid->levels[i] = storage;
+        storage += pyramid->counts[i] * lanes;
+    }
+
+    atomic_init(&pyramid->ready, 0);
+    atomic_init(&pyramid->quit, 0);
+    if(thrd_create(&pyramid->thread, &pyramid_thread, pyramid) != thrd_success) {
+        free(pyramid->levels[0]);
+        pyramid->num_levels = 0;
+        return 0;
+    }
+
+    return 1;
+}
+
+void pyramid_shutdown(struct peak_pyramid *pyramid)
+{
+    if(!pyramid->num_levels)
+        return;
+    atomic_store_explicit(&pyramid->quit, 1, memory_order_relaxed);
+    thrd_join(pyramid->thread, NULL);
+    free(pyramid->levels[0]);
+    pyramid->num_levels = 0;
+}
+
+/* Peak group of the index-th block of `block` frames,
+ * straight from the pyramid whenever it has a level
+ * of that size. */
+static void peak_at(size_t block, size_t index, struct peak *out)
+{
+    size_t level = 0;
+    size_t lanes = peak_lanes(&g_state);
+
+    if(block >= PYRAMID_BASE && g_pyramid.num_levels && atomic_load_explicit(&g_pyramid.ready, memory_order_acquire)) {
+        while(level < g_pyramid.num_levels && ((size_t)PYRAMID_BASE << level) < block)
+            level++;
+        if(level < g_pyramid.num_levels) {
+            if(index < g_pyramid.counts[level])
+                memcpy(out, g_pyramid.levels[level] + index * lanes, lanes * sizeof(struct peak));
+            else
+                memset(out, 0, lanes * sizeof(struct peak));
+            return;
+        }
+    }
+
+    scan_peaks(&g_state, index * block, block, out);
+}
+
+static int ring_thread(void *arg)
+{
+    int eof = 0;
+    size_t base, head, pos, limit, count;
+    struct pa_state *state = arg;
+    struct decode_ring *ring = state->ring;
+    const struct timespec nap = { 0, 2000000 };
+
+    ring_range(ring, &base, &head);
+    while(!atomic_load_explicit(&ring->quit, memory_order_relaxed)) {
+        pos = atomic_load_explicit(&state->position, memory_order_acquire);
+
+        /* The playhead jumped somewhere the ring doesn't
+         * cover: start over from the window behind it. The
+         * callback plays silence until the frames are back. */
+        if(pos < base || (pos > ring->history && pos - ring->history > head)) {
+            base = head = pos > ring->history ? pos - ring->history : 0;
+            ring_publish(ring, base, head);
+            eof = !drwav_seek_to_pcm_frame(&ring->wav, head);
+        }
+
+        /* Frames older than the scope window can be overwritten. */
+        limit = (pos > ring->history ? pos - ring->history : 0) + ring->mask + 1;
+        if(limit > state->num_samples)
+            limit = state->num_samples;
+
+        if(eof || head >= limit) {
+            thrd_sleep(&nap, NULL);
+            continue;
+        }
+
+        count = limit - head;
+        if(count > RING_CHUNK)
+            count = RING_CHUNK;
+        if(count > ring->mask + 1 - (head & ring->mask))
+            count = ring->mask + 1 - (head & ring->mask);
+
+        /* Readers must stop trusting the frames about to
+         * be overwritten before they are. */
+        if(head + count - base > ring->mask + 1) {
+            base = head + count - ring->mask - 1;
+            ring_publish(ring, base, head);
+        }
+
+        /* A short file, wait for the playhead to move. */
+        count = (size_t)drwav_read_pcm_frames_f32(&ring->wav, count, ring->frames + (head & ring->mask) * state->num_channels);
+        if(!count) {
+            eof = 1;
+            continue;
+        }
+
+        head += count;
+        ring_publish(ring, base, head);
+    }
+
+    return 0;
+}
+
+int ring_init(struct pa_state *state, const char *path, size_t window)
+{
+    size_t history, capacity = 1;
+    struct decode_ring *ring = safe_malloc(sizeof(struct decode_ring));
+
+    /* The trigger searches up to TRIGGER_SPAN frames
+     * before the window, the spectrum takes the
+     * largest transform right before the playhead. */
+    history = window + TRIGGER_SPAN;
+    if(history < ((size_t)1 << FFT_MAX_BITS))
+        history = (size_t)1 << FFT_MAX_BITS;
+
+    /* A second of lookahead on top of that plus some
+     * slack for the render thread lagging behind the
+     * audio callback by a frame or two. */
+    history += state->sample_rate / 8;
+    while(capacity < history + state->sample_rate)
+        capacity <<= 1;
+
+    if(!drwav_init_file(&ring->wav, path, NULL)) {
+        free(ring);
+        return 0;
+    }
+
+    ring->frames = safe_malloc(capacity * state->num_channels * sizeof(float));
+    ring->mask = capacity - 1;
+    ring->history = history;
+    atomic_init(&ring->seq, 0);
+    atomic_init(&ring->base, 0);
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->quit, 0);
+    state->ring = ring;
+
+    if(thrd_create(&ring->thread, &ring_thread, state) != thrd_success) {
+        state->ring = NULL;
+        drwav_uninit(&ring->wav);
+        free(ring->frames);
+        free(ring);
+        return 0;
+    }
+
+    return 1;
+}
+
+void ring_shutdown(struct pa_state *state)
+{
+    struct decode_ring *ring = state->ring;
+    if(!ring)
+        return;
+    atomic_store_explicit(&ring->quit, 1, memory_order_relaxed);
+    thrd_join(ring->thread, NULL);
+    drwav_uninit(&ring->wav);
+    free(ring->frames);
+    free(ring);
+    state->ring = NULL;
+}
+
+static int is_little_endian(void)
+{
+    const union { unsigned int u; unsigned char b[sizeof(unsigned int)]; } probe = { 1 };
+    return probe.b[0];
+}
+
+static int map_file(struct mapped_track *map, const char *path)
+{
+#ifdef _WIN32
+    LARGE_INTEGER size;
+    map->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(map->file == INVALID_HANDLE_VALUE)
+        return 0;
+    if(!GetFileSizeEx(map->file, &size) || !size.QuadPart) {
+        CloseHandle(map->file);
+        return 0;
+    }
+
+    map->size = (size_t)size.QuadPart;
+    map->mapping = CreateFileMappingA(map->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(!map->mapping) {
+        CloseHandle(map->file);
+        return 0;
+    }
+
+    map->base = MapViewOfFile(map->mapping, FILE_MAP_READ, 0, 0, 0);
+    if(!map->base) {
+        CloseHandle(map->mapping);
+        CloseHandle(map->file);
+        return 0;
+    }
+#else
+    int fd;
+    struct stat st;
+
+    if((fd = open(path, O_RDONLY)) < 0)
+        return 0;
+    if(fstat(fd, &st) < 0 || !st.st_size) {
+        close(fd);
+        return 0;
+    }
+
+    /* MAP_SHARED so that several instances looking
+     * at the same file share its pages. */
+    map->size = (size_t)st.st_size;
+    map->base = mmap(NULL, map->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(map->base == MAP_FAILED)
+        return 0;
+#endif
+
+    return 1;
+}
+
+static void unmap_file(struct mapped_track *map)
+{
+#ifdef _WIN32
+    UnmapViewOfFile(map->base);
+    CloseHandle(map->mapping);
+    CloseHandle(map->file);
+#else
+    munmap(map->base, map->size);
+#endif
+}
+
+int map_init(struct pa_state *state, const char *path)
+{
+    size_t i, data_size;
+    const unsigned char *data;
+    struct mapped_track *map = safe_malloc(sizeof(struct mapped_track));
+
+    if(!map_file(map, path)) {
+        free(map);
+        return 0;
+    }
+
+    if(!drwav_init_memory(&map->wav, map->base, map->size, NULL)) {
+        unmap_file(map);
+        free(map);
+        return 0;
+    }
+
+    state->sample_rate = map->wav.sampleRate;
+    state->num_channels = map->wav.channels;
+    state->num_samples = (size_t)map->wav.totalPCMFrameCount;
+    state->map = map;
+
+    data = (const unsigned char *)map->base + map->wav.dataChunkDataPos;
+    data_size = state->num_samples * state->num_channels * sizeof(float);
+    if(map->wav.translatedFormatTag == DR_WAVE_FORMAT_IEEE_FLOAT && map->wav.bitsPerSample == 32 && is_little_endian()
+        && (size_t)map->wav.dataChunkDataPos + data_size <= map->size && !((size_t)data % sizeof(float))) {
+        state->samples = (void *)data;
+        map->converted = NULL;
+        map->num_blocks = 0;
+        return 1;
+    }
+
+    /* calloc'd pages are only committed once the
+     * converter actually gets to them. */
+    map->num_blocks = (state->num_samples + MAP_BLOCK - 1) / MAP_BLOCK;
+    map->converted = safe_malloc(map->num_blocks * sizeof(atomic_uchar));
+    for(i = 0; i < map->num_blocks; i++)
+        atomic_init(&map->converted[i], 0);
+    state->samples = calloc(state->num_samples * state->num_channels, sizeof(float));
+    if(!state->samples) {
+        lprintf("out of memory!");
+        abort();
+    }
+
+    return 1;
+}
+
+/* Makes frames [first, last) readable. For in-place
+ * float data this only asks the OS to start paging
+ * them in so that nobody ends up waiting on the disk. */
+void map_convert(struct pa_state *state, size_t first, size_t last)
+{
+    size_t block;
+    struct mapped_track *map = state->map;
+
+    if(last > state->num_samples)
+        last = state->num_samples;
+    if(first >= last)
+        return;
+
+    if(!map->converted) {
+#ifndef _WIN32
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        size_t begin = (size_t)((float *)state->samples + first * state->num_channels);
+        size_t end = (size_t)((float *)state->samples + last * state->num_channels);
+        begin -= begin % page;
+        posix_madvise((void *)begin, end - begin, POSIX_MADV_WILLNEED);
+#endif
+        return;
+    }
+
+    for(block = first / MAP_BLOCK; block * MAP_BLOCK < last; block++) {
+        float *out = (float *)state->samples + block * MAP_BLOCK * state->num_channels;
+        size_t count = state->num_samples - block * MAP_BLOCK;
+        size_t read = 0;
+        if(atomic_load_explicit(&map->converted[block], memory_order_relaxed))
+            continue;
+        if(count > MAP_BLOCK)
+            count = MAP_BLOCK;
+        /* A block that cannot be decoded plays as
+         * silence rather than being retried forever. */
+        if(drwav_seek_to_pcm_frame(&map->wav, block * MAP_BLOCK))
+            read = (size_t)drwav_read_pcm_frames_f32(&map->wav, count, out);
+        else
+            lprintf("cannot seek to frame %zu", block * MAP_BLOCK);
+        if(read < count)
+            memset(out + read * state->num_channels, 0, (count - read) * state->num_channels * sizeof(float));
+        atomic_store_explicit(&map->converted[block], 1, memory_order_release);
+    }
+}
+
+/* Called by the render thread every frame to cover
+ * the scope window and the next second of playback. */
+void map_prefetch(struct pa_state *state, size_t position, size_t history)
+{
+    map_convert(state, position > history ? position - history : 0, position + state->sample_rate);
+}
+
+void map_shutdown(struct pa_state *state)
+{
+    struct mapped_track *map = state->map;
+    if(!map)
+        return;
+    if(map->converted) {
+        free(map->converted);
+        free(state->samples);
+    }
+
+    state->samples = NULL;
+    drwav_uninit(&map->wav);
+    unmap_file(map);
+    free(map);
+    state->map = NULL;
+}
+
+static size_t cpu_count(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors ? (size_t)info.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (size_t)count : 1;
+#endif
+}
+
+/* Decodes `count` frames from wherever `wav` is into
+ * `samples` from frame `first` on, in state->format. */
+static size_t decode_range(struct pa_state *state, drwav *wav, size_t first, size_t count)
+{
+    size_t i, done = 0, step;
+    float *block;
+    uint16_t *out = (uint16_t *)((unsigned char *)state->samples + first * frame_bytes(state));
+
+    if(state->format == SAMPLE_F32)
+        return (size_t)drwav_read_pcm_frames_f32(wav, count, (float *)out);
+    if(state->format == SAMPLE_S16)
+        return (size_t)drwav_read_pcm_frames_s16(wav, count, (int16_t *)out);
+
+    block = safe_malloc(MAP_BLOCK * state->num_channels * sizeof(float));
+    while(done < count) {
+        step = count - done < MAP_BLOCK ? count - done : MAP_BLOCK;
+        if(!(step = (size_t)drwav_read_pcm_frames_f32(wav, step, block)))
+            break;
+        for(i = 0; i < step * state->num_channels; i++)
+            *out++ = half_from_float(block[i]);
+        done += step;
+    }
+
+    free(block);
+    return done;
+}
+
+/* Returns 0 when the range could not even be started
+ * on, so that load_frames decodes it itself. */
+static int load_thread(void *arg)
+{
+    drwav wav;
+    struct load_range *range = arg;
+
+    if(!drwav_init_file(&wav, range->path, NULL))
+        return 0;
+    if(!drwav_seek_to_pcm_frame(&wav, range->first)) {
+        drwav_uninit(&wav);
+        return 0;
+    }
+
+    range->done = decode_range(range->state, &wav, range->first, range->count);
+    drwav_uninit(&wav);
+    return 1;
+}
+
+/* Fills the already allocated `samples` with the
+ * whole track. PCM, float and ADPCM data all seek
+ * in constant time, so big files are cut into one
+ * range per core and decoded in parallel; `wav`
+ * takes the first range itself, and any a thread
+ * could not be started on. A range that comes up
+ * short ends the track there. */
+void load_frames(struct pa_state *state, drwav *wav, const char *path)
+{
+    int decoded;
+    size_t i, threads;
+    size_t total = (size_t)wav->totalPCMFrameCount;
+    struct load_range ranges[LOAD_MAX_THREADS];
+
+    threads = cpu_count();
+    if(threads > total / LOAD_MIN_FRAMES)
+        threads = total / LOAD_MIN_FRAMES;
+    if(threads > LOAD_MAX_THREADS)
+        threads = LOAD_MAX_THREADS;
+    if(threads < 2) {
+        state->num_samples = decode_range(state, wav, 0, total);
+        return;
+    }
+
+    for(i = 0; i < threads; i++) {
+        ranges[i].state = state;
+        ranges[i].path = path;
+        ranges[i].first = i * (total / threads);
+        ranges[i].count = i + 1 < threads ? total / threads : total - ranges[i].first;
+        ranges[i].done = 0;
+        ranges[i].started = i && thrd_create(&ranges[i].thread, &load_thread, &ranges[i]) == thrd_success;
+    }
+
+    ranges[0].done = decode_range(state, wav, 0, ranges[0].count);
+    for(i = 1; i < threads; i++) {
+        decoded = 0;
+        if(ranges[i].started)
+            thrd_join(ranges[i].thread, &decoded);
+        if(decoded)
+            continue;
+        if(drwav_seek_to_pcm_frame(wav, ranges[i].first))
+            ranges[i].done = decode_range(state, wav, ranges[i].first, ranges[i].count);
+        else
+            lprintf("cannot seek to frame %zu", ranges[i].first);
+    }
+
+    state->num_samples = 0;
+    for(i = 0; i < threads; i++) {
+        state->num_samples += ranges[i].done;
+        if(ranges[i].done < ranges[i].count)
+            break;
+    }
+}
+
+/* Keeps 16-bit sources as they are and quantizes
+ * everything else to half floats. A spare word at
+ * the end lets the GPU read the samples as whole
+ * words. */
+void load_compact(struct pa_state *state, drwav *wav, const char *path)
+{
+    size_t size = (size_t)wav->totalPCMFrameCount * wav->channels * sizeof(uint16_t);
+    int narrow = wav->translatedFormatTag == DR_WAVE_FORMAT_ALAW || wav->translatedFormatTag == DR_WAVE_FORMAT_MULAW
+        || wav->translatedFormatTag == DR_WAVE_FORMAT_ADPCM || wav->translatedFormatTag == DR_WAVE_FORMAT_DVI_ADPCM
+        || (wav->translatedFormatTag == DR_WAVE_FORMAT_PCM && wav->bitsPerSample <= 16);
+
+    state->samples = safe_malloc(size + sizeof(uint32_t));
+    memset((unsigned char *)state->samples + size, 0, sizeof(uint32_t));
+    state->format = narrow ? SAMPLE_S16 : SAMPLE_F16;
+    load_frames(state, wav, path);
+}
+
+/* Nanoseconds on a clock that never goes back. */
+static uint64_t clock_ns(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER count;
+    QueryPerformanceCounter(&count);
+    return (uint64_t)count.QuadPart / g_clock_frequency * 1000000000 + (uint64_t)count.QuadPart % g_clock_frequency * 1000000000 / g_clock_frequency;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+void callback_stats_init(struct callback_stats *stats)
+{
+    size_t i;
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+
+    QueryPerformanceFrequency(&frequency);
+    g_clock_frequency = (uint64_t)frequency.QuadPart;
+#endif
+
+    atomic_init(&stats->calls, 0);
+    atomic_init(&stats->underflows, 0);
+    atomic_init(&stats->overflows, 0);
+    atomic_init(&stats->starved, 0);
+    atomic_init(&stats->late, 0);
+    atomic_init(&stats->longest, 0);
+    atomic_init(&stats->budget, 0);
+    for(i = 0; i < CALLBACK_BUCKETS; i++)
+        atomic_init(&stats->durations[i], 0);
+}
+
+/* Only ever called from the callback, so the longest
+ * duration needs no compare and swap. */
+static void callback_record(struct callback_stats *stats, PaStreamCallbackFlags flags, int starved, uint64_t ns, uint64_t budget)
+{
+    size_t bucket = 0;
+    uint64_t n;
+
+    for(n = ns; n > 1 && bucket + 1 < CALLBACK_BUCKETS; n >>= 1)
+        bucket++;
+
+    atomic_fetch_add_explicit(&stats->calls, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->durations[bucket], 1, memory_order_relaxed);
+    if(flags & paOutputUnderflow)
+        atomic_fetch_add_explicit(&stats->underflows, 1, memory_order_relaxed);
+    if(flags & paOutputOverflow)
+        atomic_fetch_add_explicit(&stats->overflows, 1, memory_order_relaxed);
+    if(starved)
+        atomic_fetch_add_explicit(&stats->starved, 1, memory_order_relaxed);
+    if(ns > budget)
+        atomic_fetch_add_explicit(&stats->late, 1, memory_order_relaxed);
+    if(ns > atomic_load_explicit(&stats->longest, memory_order_relaxed))
+        atomic_store_explicit(&stats->longest, (size_t)(ns < SIZE_MAX ? ns : SIZE_MAX), memory_order_relaxed);
+    atomic_store_explicit(&stats->budget, (size_t)(budget < SIZE_MAX ? budget : SIZE_MAX), memory_order_relaxed);
+}
+
+/* Upper end of the bucket that `fraction` of the
+ * calls fall into or below, 0 before the first. */
+double callback_percentile(const struct callback_stats *stats, double fraction)
+{
+    size_t i, calls, below = 0;
+
+    calls = atomic_load_explicit(&stats->calls, memory_order_relaxed);
+    if(!calls)
+        return 0.0;
+
+    for(i = 0; i + 1 < CALLBACK_BUCKETS; i++) {
+        below += atomic_load_explicit(&stats->durations[i], memory_order_relaxed);
+        if((double)below >= fraction * (double)calls)
+            break;
+    }
+
+    return (double)((uint64_t)2 << i);
+}
+
+void print_callback_stats(const struct callback_stats *stats)
+{
+    size_t i, count;
+
+    lprintf("callback: %zu calls, %zu underflows, %zu overflows, %zu starved, %zu late", atomic_load_explicit(&stats->calls, memory_order_relaxed),
+        atomic_load_explicit(&stats->underflows, memory_order_relaxed), atomic_load_explicit(&stats->overflows, memory_order_relaxed),
+        atomic_load_explicit(&stats->starved, memory_order_relaxed), atomic_load_explicit(&stats->late, memory_order_relaxed));
+    lprintf("callback: longest %.3f ms, p99 under %.3f ms, buffers of %.3f ms", (double)atomic_load_explicit(&stats->longest, memory_order_relaxed) * 1e-6,
+        callback_percentile(stats, 0.99) * 1e-6, (double)atomic_load_explicit(&stats->budget, memory_order_relaxed) * 1e-6);
+
+    for(i = 0; i < CALLBACK_BUCKETS; i++) {
+        count = atomic_load_explicit(&stats->durations[i], memory_order_relaxed);
+        if(count)
+            lprintf("callback: under %10.3f ms %zu", (double)((uint64_t)2 << i) * 1e-6, count);
+    }
+}
+
+int pa_callback(const void *input, void *output, unsigned long framerate, const PaStreamCallbackTimeInfo *time_info, PaStreamCallbackFlags flags, void *arg)
+{
+    size_t position, start, ready, seek;
+    unsigned long i = 0;
+    float *fl_output = output;
+    struct pa_state *state = arg;
+    uint64_t begin = clock_ns();
+    int starved = 0;
+
+    position = atomic_load_explicit(&state->position, memory_order_relaxed);
+    seek = atomic_exchange_explicit(&state->seek, SIZE_MAX, memory_order_acquire);
+    if(seek != SIZE_MAX)
+        position = seek;
+
+    start = position;
+    if(!atomic_load_explicit(&state->paused, memory_order_acquire)) {
+        ready = frames_ready(state, position);
+        for(; i < framerate; i++) {
+            if(position >= state->num_samples) {
+                /* Hold at the end rather than completing
+                 * the stream so that a seek still works. */
+                if(!atomic_load_explicit(&state->loop, memory_order_relaxed)) {
+                    atomic_store_explicit(&state->paused, 1, memory_order_relaxed);
+                    break;
+                }
+
+                position = 0;
+                ready = frames_ready(state, position);
+            }
+
+            /* The decoder fell behind or hasn't caught up
+             * with a seek yet, play silence meanwhile. */
+            if(position >= ready) {
+                starved = 1;
+                break;
+            }
+
+            output_frame(state, position, fl_output);
+            fl_output += state->num_channels;
+            position++;
+        }
+    }
+
+    memset(fl_output, 0, (framerate - i) * state->num_channels * sizeof(float));
+    publish_playhead(state, position, start, time_info->outputBufferDacTime);
+    callback_record(&state->stats, flags, starved, clock_ns() - begin, (uint64_t)framerate * 1000000000 / state->sample_rate);
+    return paContinue;
+}
+
+/* Values per lane of the wave table: room for the
+ * raw window or for the min/max and RMS pairs of a
+ * few blocks per column. */
+size_t wave_table_size(int scr_width)
+{
+    size_t size = (size_t)scr_width * 8 + 16;
+    return size < g_window_frames ? g_window_frames : size;
+}
+
+/* Every lane that can be shown at once. */
+size_t wave_table_lanes(const struct pa_state *state)
+{
+    return peak_lanes(state) > state->num_channels ? peak_lanes(state) : state->num_channels;
+}
+
+/* Smallest power-of-two block that puts no more than
+ * two min/max pairs in a pixel column and still fits
+ * the wave table. A block of one means raw samples. */
+static size_t pick_block(size_t num_samples, int scr_width)
+{
+    size_t block = 1;
+    size_t columns = scr_width > 0 ? (size_t)scr_width : 1;
+    while(block * columns * 2 < num_samples)
+        block <<= 1;
+    while(block > 1 && (num_samples / block + 2) * 4 + 2 > g_wave_table_size)
+        block <<= 1;
+    return block;
+}
+
+/* Every lane gets the same layout, g_lane_stride
+ * values apart: g_wave_count values of the trace
+ * followed by g_rms_count of the RMS band. Only y is
+ * stored, the UBO says how x advances. */
+void fill_signal_tab(struct ubo_data *ubo, int scr_width, size_t position)
+{
+    size_t i, j, block, index, blocks, lead;
+    int64_t first, start;
+    const void *frame;
+    const struct peak *peak;
+    struct peak peaks[MAX_LANES + 1];
+    float *lane;
+    size_t mix = peak_lanes(&g_state) - 1;
+    size_t num_samples = g_state.num_samples - position;
+    if(num_samples > g_view_frames)
+        num_samples = g_view_frames;
+
+    /* An empty track or a playhead at its very end leaves
+     * nothing to draw and nothing to divide by. */
+    if(!num_samples) {
+        g_wave_count = g_rms_count = g_lane_stride = 0;
+        ubo->lanes[2] = ubo->lanes[3] = 0;
+        ubo->wave[0] = -1.0f;
+        ubo->wave[1] = 0.0f;
+        return;
+    }
+
+    /* The window ends at the playhead; whatever falls
+     * before the start of the file, or before the oldest
+     * frame the decoder still has, is zero. */
+    first = (int64_t)position - (int64_t)num_samples;
+    start = (int64_t)frames_base(&g_state);
+    if(start < first)
+        start = first;
+    block = pick_block(num_samples, scr_width);
+
+    if(block == 1) {
+        g_wave_count = g_lane_stride = num_samples;
+        g_rms_count = 0;
+        ubo->lanes[2] = (uint32_t)num_samples;
+        ubo->lanes[3] = 0;
+        ubo->wave[0] = -1.0f;
+        ubo->wave[1] = 2.0f / (float)num_samples;
+        for(i = 0; i < num_samples; i++) {
+            frame = first + (int64_t)i >= start ? frame_at(&g_state, (size_t)(first + (int64_t)i)) : NULL;
+            for(j = 0; j < g_lanes; j++) {
+                lane = g_wave_table + j * num_samples;
+                lane[i] = 0.0f;
+                if(frame)
+                    lane[i] = g_lanes > 1 ? frame_sample(&g_state, frame, j) : mix_at(&g_state, (size_t)(first + (int64_t)i));
+            }
+        }
+
+        return;
+    }
+
+    /* Each block becomes a min and a max vertex half a
+     * block apart, the RMS band goes right after them.
+     * The lead-in is a flat line from the left edge to
+     * half a block before the first one. */
+    index = (size_t)start / block;
+    blocks = (position - index * block + block - 1) / block;
+    lead = first < start ? 2 : 0;
+    g_wave_count = lead + blocks * 2;
+    g_rms_count = blocks * 2;
+    g_lane_stride = g_wave_count + g_rms_count;
+    ubo->lanes[2] = (uint32_t)g_wave_count;
+    ubo->lanes[3] = (uint32_t)lead;
+    ubo->wave[1] = (float)block / (float)num_samples;
+    ubo->wave[0] = (float)((int64_t)(index * block) - first) / (float)num_samples * 2.0f - 1.0f - ubo->wave[1] * (float)lead;
+
+    for(j = 0; j < g_lanes && lead; j++) {
+        lane = g_wave_table + j * g_lane_stride;
+        lane[0] = 0.0f;
+        lane[1] = 0.0f;
+    }
+
+    for(i = 0; i < blocks; i++, index++) {
+        peak_at(block, index, peaks);
+        for(j = 0; j < g_lanes; j++) {
+            peak = &peaks[g_lanes > 1 ? j : mix];
+            lane = g_wave_table + j * g_lane_stride;
+
+            lane[lead + i * 2] = peak->min;
+            lane[lead + i * 2 + 1] = peak->max;
+
+            lane[g_wave_count + i * 2] = -sqrtf(peak->ms);
+            lane[g_wave_count + i * 2 + 1] = sqrtf(peak->ms);
+        }
+    }
+}
+
+/* upload_frames into memory the GPU reads directly. */
+void copy_frames(void *out, size_t first, size_t last)
+{
+    size_t part;
+    unsigned char *dst = out;
+
+    while(first < last) {
+        part = last - first;
+        if(g_state.ring && part > g_state.ring->mask + 1 - (first & g_state.ring->mask))
+            part = g_state.ring->mask + 1 - (first & g_state.ring->mask);
+        memcpy(dst, frame_at(&g_state, first), part * frame_bytes(&g_state));
+        dst += part * frame_bytes(&g_state);
+        first += part;
+    }
+}
+
@@ -0,0 +1,376 @@
+/* What scope and scope_bench share: the track in
+ * memory and the decoders that fill it, the audio
+ * callback and the CPU side of the wave table. None
+ * of it touches GL or opens a window. */
+#ifndef SCOPE_CORE_H
+#define SCOPE_CORE_H
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN 1
+#include <windows.h>
+#endif
+
+#include <math.h>
+#include <portaudio.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* macOS and older MSVC have no C11 threads. */
+#if defined(__STDC_NO_THREADS__) || defined(__APPLE__) || (defined(_MSC_VER) && _MSC_VER < 1938)
+#define SCOPE_THREADS_SHIM 1
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+#else
+#include <threads.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SCOPE_SSE2 1
+#endif
+
+#include "dr_wav.h"
+
+/* The little of threads.h that is used here, on top
+ * of pthreads or Win32 threads. The start routine and
+ * its argument go through the heap to a trampoline
+ * that has the signature the platform wants. */
+#ifdef SCOPE_THREADS_SHIM
+typedef int (*thrd_start_t)(void *);
+
+enum {
+    thrd_success,
+    thrd_error
+};
+
+struct thrd_start {
+    thrd_start_t func;
+    void *arg;
+};
+
+#ifdef _WIN32
+typedef HANDLE thrd_t;
+
+static inline DWORD WINAPI thrd_trampoline(LPVOID arg)
+{
+    struct thrd_start start = *(struct thrd_start *)arg;
+    free(arg);
+    return (DWORD)start.func(start.arg);
+}
+#else
+typedef pthread_t thrd_t;
+
+static void *thrd_trampoline(void *arg)
+{
+    struct thrd_start start = *(struct thrd_start *)arg;
+    free(arg);
+    return (void *)(intptr_t)start.func(start.arg);
+}
+#endif
+
+static inline int thrd_create(thrd_t *thread, thrd_start_t func, void *arg)
+{
+    struct thrd_start *start = malloc(sizeof(struct thrd_start));
+    if(!start)
+        return thrd_error;
+
+    start->func = func;
+    start->arg = arg;
+#ifdef _WIN32
+    if((*thread = CreateThread(NULL, 0, &thrd_trampoline, start, 0, NULL)))
+        return thrd_success;
+#else
+    if(!pthread_create(thread, NULL, &thrd_trampoline, start))
+        return thrd_success;
+#endif
+
+    free(start);
+    return thrd_error;
+}
+
+static inline int thrd_join(thrd_t thread, int *result)
+{
+#ifdef _WIN32
+    DWORD code;
+    if(WaitForSingleObject(thread, INFINITE) != WAIT_OBJECT_0 || !GetExitCodeThread(thread, &code))
+        return thrd_error;
+    CloseHandle(thread);
+#else
+    void *code;
+    if(pthread_join(thread, &code))
+        return thrd_error;
+#endif
+
+    if(result)
+        *result = (int)(intptr_t)code;
+    return thrd_success;
+}
+
+static inline int thrd_sleep(const struct timespec *duration, struct timespec *remaining)
+{
+#ifdef _WIN32
+    Sleep((DWORD)(duration->tv_sec * 1000 + (duration->tv_nsec + 999999) / 1000000));
+    return 0;
+#else
+    return nanosleep(duration, remaining) ? -1 : 0;
+#endif
+}
+#endif
+
+#define RING_CHUNK 4096 /* frames decoded per drwav call */
+#define MAP_BLOCK 16384 /* frames converted at once     */
+
+#define LOAD_MIN_FRAMES 1048576 /* frames worth a loader thread */
+#define LOAD_MAX_THREADS 64
+
+#define PYRAMID_BASE 16 /* frames per peak at the finest level */
+#define PYRAMID_MAX_LEVELS 48
+
+#define TRIGGER_SPAN 65536 /* frames searched for a trigger per frame */
+
+#define MAX_LANES 32 /* channels that get a trace of their own */
+
+#define FFT_MIN_BITS 10 /* 1k point transform  */
+#define FFT_MAX_BITS 16 /* 64k point transform */
+
+#define OUTPUT_GAIN 0.25f /* applied to everything that gets played */
+#define CALLBACK_BUCKETS 32 /* power-of-two nanoseconds, up to 2 s */
+
+typedef double  vec2d_t[2];
+typedef float   vec2f_t[2];
+typedef float   vec3f_t[3];
+typedef float   vec4f_t[4];
+typedef uint32_t vec4u_t[4];
+
+struct ubo_data {
+    vec4f_t xyz_color;
+    vec4f_t x_dt_yz_screen;
+    vec4u_t track; /* x: first frame, y: leading zeros, z: frame count, w: channels */
+    vec4u_t lanes; /* x: lane count, y: vertices per lane, z: trace vertices, w: leading vertices */
+    vec4f_t wave; /* x: x of the first vertex, y: x step between vertices */
+    vec4u_t storage; /* x: sample format of the frames */
+    vec4f_t waterfall; /* x: texture offset of the oldest column */
+    vec4f_t line; /* x: width in pixels */
+    vec4f_t lane_color[MAX_LANES]; /* xyz: color, w: vertical offset */
+};
+
+/* Streaming mode keeps the drwav handle open and
+ * decodes into a power-of-two ring of frames. The
+ * ring holds `history` frames behind the playhead
+ * for the window, the trigger and the spectrum;
+ * everything else is lookahead.
+ * Frames [base, head) are valid, the pair is published
+ * under `seq` so that it can jump after a seek. */
+struct decode_ring {
+    drwav wav;
+    float *frames;
+    size_t mask;
+    size_t history;
+    atomic_uint seq;
+    atomic_size_t base;
+    atomic_size_t head;
+    atomic_bool quit;
+    thrd_t thread;
+};
+
+/* Mapped mode reads the file through the page cache.
+ * 32-bit float data is used in place; anything else
+ * is converted into `samples` one block at a time by
+ * the render thread, ahead of the playhead. */
+struct mapped_track {
+    void *base;
+    size_t size;
+    drwav wav;
+    atomic_uchar *converted;
+    size_t num_blocks;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+};
+
+struct peak {
+    float min;
+    float max;
+    float ms; /* mean square */
+};
+
+/* Level N holds one group of peaks per PYRAMID_BASE
+ * << N frames, laid out as described for peak_lanes.
+ * It is built in the background and used once
+ * `ready` is set. */
+struct peak_pyramid {
+    struct peak *levels[PYRAMID_MAX_LEVELS];
+    size_t counts[PYRAMID_MAX_LEVELS];
+    size_t num_levels;
+    atomic_bool ready;
+    atomic_bool quit;
+    thrd_t thread;
+};
+
+
+/* Kept by the audio callback for whoever wants to
+ * look, plain counters with relaxed atomics since
+ * nothing is ordered on them. Durations go in
+ * buckets by the power of two of their nanoseconds,
+ * `budget` is how long the last buffer plays for. */
+struct callback_stats {
+    atomic_size_t calls;
+    atomic_size_t underflows;
+    atomic_size_t overflows;
+    atomic_size_t starved; /* buffers cut short waiting on the decoder */
+    atomic_size_t late;    /* took longer than their buffer plays for  */
+    atomic_size_t longest; /* ns */
+    atomic_size_t budget;  /* ns */
+    atomic_size_t durations[CALLBACK_BUCKETS];
+};
+
+/* How a preloaded track keeps its samples; the
+ * decode ring and mapped tracks are always float. */
+enum sample_format {
+    SAMPLE_F32,
+    SAMPLE_S16,
+    SAMPLE_F16
+};
+
+
+/* Everything the audio callback shares with the other
+ * threads. The track description at the top is written
+ * before the stream or any worker starts and is never
+ * modified afterwards. The playhead is only written by
+ * the callback and published with a sequence counter
+ * (odd while an update is in progress). Transport
+ * requests from the UI thread are picked up by the
+ * callback with plain atomic loads and exchanges,
+ * nothing on the audio path ever takes a lock. */
+struct pa_state {
+    size_t sample_rate;
+    size_t num_samples;
+    size_t num_channels;
+    void *samples;
+    enum sample_format format;
+    struct decode_ring *ring;
+    struct mapped_track *map;
+
+    atomic_uint seq;
+    atomic_size_t position;
+    atomic_size_t dac_frame;
+    _Atomic double dac_time;
+
+    atomic_size_t seek; /* SIZE_MAX when there is nothing to do */
+    atomic_bool paused;
+    atomic_bool loop;
+
+    struct callback_stats stats;
+};
+
+/* `position` is the next frame the callback will
+ * produce, `dac_frame` the first frame of the last
+ * buffer it produced, which reaches the DAC at
+ * `dac_time` in PortAudio stream time. */
+struct playhead {
+    size_t position;
+    size_t dac_frame;
+    double dac_time;
+};
+
+extern struct pa_state g_state;
+extern struct peak_pyramid g_pyramid;
+extern float *g_wave_table;
+extern size_t g_wave_table_size;
+extern size_t g_wave_count;
+extern size_t g_rms_count;
+extern size_t g_lanes;
+extern size_t g_lane_stride;
+extern size_t g_window_frames;
+extern size_t g_view_frames;
+
+void lprintf(const char *fmt, ...);
+void *safe_malloc(size_t n);
+
+static inline float half_to_float(uint16_t h)
+{
+    uint32_t bits;
+    uint32_t sign = (uint32_t)(h & 0x8000u) << 16;
+    uint32_t exp = (h >> 10) & 0x1fu;
+    uint32_t mant = h & 0x3ffu;
+    float f;
+
+    if(!exp) {
+        f = ldexpf((float)mant, -24);
+        return sign ? -f : f;
+    }
+
+    bits = sign | (exp == 0x1fu ? 0x7f800000u : (exp + 112) << 23) | mant << 13;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+static inline size_t frame_bytes(const struct pa_state *state)
+{
+    return state->num_channels * (state->format == SAMPLE_F32 ? sizeof(float) : sizeof(uint16_t));
+}
+
+/* The frame as stored, see frame_sample to read it. */
+static inline const void *frame_at(const struct pa_state *state, size_t frame)
+{
+    if(state->ring)
+        return state->ring->frames + (frame & state->ring->mask) * state->num_channels;
+    return (const unsigned char *)state->samples + frame * frame_bytes(state);
+}
+
+static inline float frame_sample(const struct pa_state *state, const void *frame, size_t channel)
+{
+    switch(state->format) {
+    case SAMPLE_S16:
+        return (float)((const int16_t *)frame)[channel] * (1.0f / 32768.0f);
+    case SAMPLE_F16:
+        return half_to_float(((const uint16_t *)frame)[channel]);
+    default:
+        return ((const float *)frame)[channel];
+    }
+}
+
+static inline float mix_at(const struct pa_state *state, size_t frame)
+{
+    size_t j;
+    float sum = 0.0f;
+    const void *samples = frame_at(state, frame);
+    for(j = 0; j < state->num_channels; j++)
+        sum += frame_sample(state, samples, j);
+    return sum / (float)state->num_channels;
+}
+
+size_t frames_base(struct pa_state *state);
+struct playhead read_playhead(struct pa_state *state);
+size_t predict_position(const struct playhead *head, double when);
+void request_seek(struct pa_state *state, size_t position);
+void output_frame(const struct pa_state *state, size_t frame, float *out);
+
+int pyramid_init(struct peak_pyramid *pyramid);
+void pyramid_shutdown(struct peak_pyramid *pyramid);
+
+int ring_init(struct pa_state *state, const char *path, size_t window);
+void ring_shutdown(struct pa_state *state);
+int map_init(struct pa_state *state, const char *path);
+void map_convert(struct pa_state *state, size_t first, size_t last);
+void map_prefetch(struct pa_state *state, size_t position, size_t history);
+void map_shutdown(struct pa_state *state);
+void load_frames(struct pa_state *state, drwav *wav, const char *path);
+void load_compact(struct pa_state *state, drwav *wav, const char *path);
+void callback_stats_init(struct callback_stats *stats);
+double callback_percentile(const struct callback_stats *stats, double fraction);
+void print_callback_stats(const struct callback_stats *stats);
+int pa_callback(const void *input, void *output, unsigned long framerate, const PaStreamCallbackTimeInfo *time_info, PaStreamCallbackFlags flags, void *arg);
+
+size_t wave_table_size(int scr_width);
+size_t wave_table_lanes(const struct pa_state *state);
+void fill_signal_tab(struct ubo_data *ubo, int scr_width, size_t position);
+void copy_frames(void *out, size_t first, size_t last);
+
+#endif